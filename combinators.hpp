@@ -0,0 +1,433 @@
+#ifndef GKXX_COMBINATORS_HPP
+#define GKXX_COMBINATORS_HPP
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "generator.hpp"
+
+// concat, interleave and merge_sorted over Generators or any other input
+// ranges. The inputs are driven directly through their iterators; none of
+// them is wrapped in an extra coroutine.
+//
+//   merge_sorted(gen1, gen2, vec)    variadic form, inputs may differ in type
+//   merge_sorted(vector_of_gens)     range form, for a runtime number of inputs
+//
+// A single argument whose elements are themselves input ranges selects the
+// range form.
+
+namespace gkxx {
+
+namespace detail {
+
+  // A fixed set of input ranges of possibly different types, advanced by a
+  // runtime index through tables of function pointers.
+  template <typename... Views>
+  class source_pack {
+   public:
+    using reference =
+        std::common_reference_t<std::ranges::range_reference_t<Views>...>;
+    using index_buffer = std::array<std::size_t, sizeof...(Views)>;
+
+    template <typename... Rngs>
+    explicit source_pack(Rngs &&...rngs)
+        : m_views{std::views::all(std::forward<Rngs>(rngs))...} {}
+
+    void start() {
+      std::apply(
+          [this](auto &...views) {
+            std::apply(
+                [&](auto &...its) {
+                  (its.emplace(std::ranges::begin(views)), ...);
+                },
+                m_iterators);
+          },
+          m_views);
+    }
+
+    static constexpr std::size_t size() noexcept {
+      return sizeof...(Views);
+    }
+
+    static index_buffer make_index_buffer() noexcept {
+      return {};
+    }
+
+    bool done(std::size_t i) {
+      return done_table[i](*this);
+    }
+    reference get(std::size_t i) {
+      return get_table[i](*this);
+    }
+    void next(std::size_t i) {
+      next_table[i](*this);
+    }
+
+   private:
+    template <std::size_t I>
+    static bool done_impl(source_pack &self) {
+      return *std::get<I>(self.m_iterators) ==
+             std::ranges::end(std::get<I>(self.m_views));
+    }
+    template <std::size_t I>
+    static reference get_impl(source_pack &self) {
+      return **std::get<I>(self.m_iterators);
+    }
+    template <std::size_t I>
+    static void next_impl(source_pack &self) {
+      ++*std::get<I>(self.m_iterators);
+    }
+
+    static constexpr auto done_table =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+          return std::array{&done_impl<Is>...};
+        }(std::index_sequence_for<Views...>{});
+    static constexpr auto get_table =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+          return std::array{&get_impl<Is>...};
+        }(std::index_sequence_for<Views...>{});
+    static constexpr auto next_table =
+        []<std::size_t... Is>(std::index_sequence<Is...>) {
+          return std::array{&next_impl<Is>...};
+        }(std::index_sequence_for<Views...>{});
+
+    std::tuple<Views...> m_views;
+    std::tuple<std::optional<std::ranges::iterator_t<Views>>...> m_iterators;
+  };
+
+  // A runtime number of input ranges of the same type, held by a range of
+  // ranges such as std::vector<Generator<T>>.
+  template <typename View>
+  class source_list {
+    using inner_range =
+        std::remove_reference_t<std::ranges::range_reference_t<View>>;
+
+    struct cursor {
+      std::ranges::iterator_t<inner_range> it;
+      std::ranges::sentinel_t<inner_range> end;
+    };
+
+   public:
+    using reference = std::ranges::range_reference_t<inner_range>;
+    using index_buffer = std::vector<std::size_t>;
+
+    template <typename Rng>
+    explicit source_list(Rng &&rng)
+        : m_view{std::views::all(std::forward<Rng>(rng))} {}
+
+    void start() {
+      if constexpr (std::ranges::sized_range<View>)
+        m_cursors.reserve(std::ranges::size(m_view));
+      for (auto &&inner : m_view)
+        m_cursors.push_back(
+            cursor{std::ranges::begin(inner), std::ranges::end(inner)});
+    }
+
+    std::size_t size() const noexcept {
+      return m_cursors.size();
+    }
+
+    index_buffer make_index_buffer() const {
+      return index_buffer(m_cursors.size());
+    }
+
+    bool done(std::size_t i) {
+      return m_cursors[i].it == m_cursors[i].end;
+    }
+    reference get(std::size_t i) {
+      return *m_cursors[i].it;
+    }
+    void next(std::size_t i) {
+      ++m_cursors[i].it;
+    }
+
+   private:
+    View m_view;
+    std::vector<cursor> m_cursors;
+  };
+
+  template <typename Rng>
+  concept range_of_ranges =
+      std::ranges::input_range<Rng> && std::ranges::viewable_range<Rng> &&
+      std::ranges::input_range<std::ranges::range_reference_t<Rng>> &&
+      std::is_lvalue_reference_v<std::ranges::range_reference_t<Rng>>;
+
+  template <typename... Rngs>
+  concept source_ranges =
+      sizeof...(Rngs) > 0 &&
+      (... && (std::ranges::input_range<Rngs> &&
+               std::ranges::viewable_range<Rngs>)) &&
+      requires {
+        typename std::common_reference_t<
+            std::ranges::range_reference_t<std::views::all_t<Rngs>>...>;
+      };
+
+  template <typename... Rngs>
+  using source_pack_for = source_pack<std::views::all_t<Rngs>...>;
+
+  template <typename Rng>
+  using source_list_for = source_list<std::views::all_t<Rng>>;
+
+  // Single-pass view whose iterator refers back to the view, like
+  // Generator<T>::iterator refers back to its coroutine.
+  template <typename Derived, typename Sources>
+  class combinator_base {
+   public:
+    using reference = typename Sources::reference;
+
+    class iterator {
+      Derived *m_view;
+
+     public:
+      using value_type = std::remove_cvref_t<reference>;
+      using difference_type = std::ptrdiff_t;
+      using iterator_category = std::input_iterator_tag;
+
+      explicit iterator(Derived *view) noexcept : m_view{view} {}
+
+      bool operator==(std::default_sentinel_t) const {
+        return m_view->at_end();
+      }
+      iterator &operator++() {
+        m_view->advance();
+        return *this;
+      }
+      void operator++(int) {
+        ++*this;
+      }
+      reference operator*() const {
+        return m_view->current();
+      }
+    };
+
+    iterator begin() {
+      auto &self = static_cast<Derived &>(*this);
+      m_sources.start();
+      self.on_start();
+      return iterator{&self};
+    }
+    std::default_sentinel_t end() const noexcept {
+      return {};
+    }
+
+   protected:
+    template <typename... Args>
+    explicit combinator_base(Args &&...args)
+        : m_sources(std::forward<Args>(args)...) {}
+
+    Sources m_sources;
+  };
+
+} // namespace detail
+
+template <typename Sources>
+class concat_view
+    : public detail::combinator_base<concat_view<Sources>, Sources> {
+  using base = detail::combinator_base<concat_view, Sources>;
+  friend base;
+  using base::m_sources;
+
+  std::size_t m_current = 0;
+
+  void skip_finished() {
+    while (m_current != m_sources.size() && m_sources.done(m_current))
+      ++m_current;
+  }
+
+  void on_start() {
+    m_current = 0;
+    skip_finished();
+  }
+  bool at_end() const noexcept {
+    return m_current == m_sources.size();
+  }
+  typename base::reference current() {
+    return m_sources.get(m_current);
+  }
+  void advance() {
+    m_sources.next(m_current);
+    skip_finished();
+  }
+
+ public:
+  template <typename... Args>
+  explicit concat_view(Args &&...args) : base(std::forward<Args>(args)...) {}
+};
+
+template <typename Sources>
+class interleave_view
+    : public detail::combinator_base<interleave_view<Sources>, Sources> {
+  using base = detail::combinator_base<interleave_view, Sources>;
+  friend base;
+  using base::m_sources;
+
+  // Indices of the sources that are not exhausted yet, in round-robin order.
+  typename Sources::index_buffer m_active{};
+  std::size_t m_count = 0;
+  std::size_t m_pos = 0;
+
+  void remove_at(std::size_t pos) {
+    for (auto i = pos; i + 1 < m_count; ++i)
+      m_active[i] = m_active[i + 1];
+    --m_count;
+  }
+
+  void on_start() {
+    m_active = m_sources.make_index_buffer();
+    m_count = 0;
+    m_pos = 0;
+    for (std::size_t i = 0; i != m_sources.size(); ++i)
+      if (!m_sources.done(i))
+        m_active[m_count++] = i;
+  }
+  bool at_end() const noexcept {
+    return m_count == 0;
+  }
+  typename base::reference current() {
+    return m_sources.get(m_active[m_pos]);
+  }
+  void advance() {
+    auto index = m_active[m_pos];
+    m_sources.next(index);
+    if (m_sources.done(index))
+      remove_at(m_pos);
+    else
+      ++m_pos;
+    if (m_pos >= m_count)
+      m_pos = 0;
+  }
+
+ public:
+  template <typename... Args>
+  explicit interleave_view(Args &&...args)
+      : base(std::forward<Args>(args)...) {}
+};
+
+// Binary min-heap of source indices keyed by each source's current element.
+// Equal elements are produced in the order of their sources, so the merge is
+// stable.
+template <typename Sources, typename Comp>
+class merge_sorted_view
+    : public detail::combinator_base<merge_sorted_view<Sources, Comp>,
+                                     Sources> {
+  using base = detail::combinator_base<merge_sorted_view, Sources>;
+  friend base;
+  using base::m_sources;
+
+  [[no_unique_address]] Comp m_comp;
+  typename Sources::index_buffer m_heap{};
+  std::size_t m_count = 0;
+
+  bool before(std::size_t a, std::size_t b) {
+    if (std::invoke(m_comp, m_sources.get(a), m_sources.get(b)))
+      return true;
+    if (std::invoke(m_comp, m_sources.get(b), m_sources.get(a)))
+      return false;
+    return a < b;
+  }
+
+  void sift_down(std::size_t pos) {
+    auto index = m_heap[pos];
+    while (true) {
+      auto child = 2 * pos + 1;
+      if (child >= m_count)
+        break;
+      if (child + 1 < m_count && before(m_heap[child + 1], m_heap[child]))
+        ++child;
+      if (!before(m_heap[child], index))
+        break;
+      m_heap[pos] = m_heap[child];
+      pos = child;
+    }
+    m_heap[pos] = index;
+  }
+
+  void on_start() {
+    m_heap = m_sources.make_index_buffer();
+    m_count = 0;
+    for (std::size_t i = 0; i != m_sources.size(); ++i)
+      if (!m_sources.done(i))
+        m_heap[m_count++] = i;
+    for (auto pos = m_count / 2; pos-- != 0;)
+      sift_down(pos);
+  }
+  bool at_end() const noexcept {
+    return m_count == 0;
+  }
+  typename base::reference current() {
+    return m_sources.get(m_heap[0]);
+  }
+  void advance() {
+    auto top = m_heap[0];
+    m_sources.next(top);
+    if (m_sources.done(top)) {
+      if (--m_count == 0)
+        return;
+      m_heap[0] = m_heap[m_count];
+    }
+    sift_down(0);
+  }
+
+ public:
+  template <typename... Args>
+  explicit merge_sorted_view(Comp comp, Args &&...args)
+      : base(std::forward<Args>(args)...), m_comp(std::move(comp)) {}
+};
+
+template <detail::range_of_ranges Rng>
+inline auto concat(Rng &&rng) {
+  return concat_view<detail::source_list_for<Rng>>(std::forward<Rng>(rng));
+}
+
+template <typename... Rngs>
+  requires detail::source_ranges<Rngs...> &&
+           (sizeof...(Rngs) != 1 || !(... && detail::range_of_ranges<Rngs>))
+inline auto concat(Rngs &&...rngs) {
+  return concat_view<detail::source_pack_for<Rngs...>>(
+      std::forward<Rngs>(rngs)...);
+}
+
+template <detail::range_of_ranges Rng>
+inline auto interleave(Rng &&rng) {
+  return interleave_view<detail::source_list_for<Rng>>(std::forward<Rng>(rng));
+}
+
+template <typename... Rngs>
+  requires detail::source_ranges<Rngs...> &&
+           (sizeof...(Rngs) != 1 || !(... && detail::range_of_ranges<Rngs>))
+inline auto interleave(Rngs &&...rngs) {
+  return interleave_view<detail::source_pack_for<Rngs...>>(
+      std::forward<Rngs>(rngs)...);
+}
+
+template <typename Comp, detail::range_of_ranges Rng>
+inline auto merge_sorted_by(Comp comp, Rng &&rng) {
+  return merge_sorted_view<detail::source_list_for<Rng>, Comp>(
+      std::move(comp), std::forward<Rng>(rng));
+}
+
+template <typename Comp, typename... Rngs>
+  requires detail::source_ranges<Rngs...> &&
+           (sizeof...(Rngs) != 1 || !(... && detail::range_of_ranges<Rngs>))
+inline auto merge_sorted_by(Comp comp, Rngs &&...rngs) {
+  return merge_sorted_view<detail::source_pack_for<Rngs...>, Comp>(
+      std::move(comp), std::forward<Rngs>(rngs)...);
+}
+
+template <typename... Rngs>
+  requires detail::source_ranges<Rngs...>
+inline auto merge_sorted(Rngs &&...rngs) {
+  return merge_sorted_by(std::ranges::less{}, std::forward<Rngs>(rngs)...);
+}
+
+} // namespace gkxx
+
+#endif // GKXX_COMBINATORS_HPP
@@ -0,0 +1,155 @@
+#ifndef GKXX_CORO_ASYNC_GENERATOR_HPP
+#define GKXX_CORO_ASYNC_GENERATOR_HPP
+
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace gkxx {
+
+// A generator whose body may co_await (e.g. scheduler.suspend()) between
+// yields. The consumer is a coroutine too:
+//
+//   auto it = gen.begin();
+//   while (co_await it.next())
+//     use(*it);
+//
+// Control passes between producer and consumer through symmetric transfer;
+// the scheduler queue is only involved when the producer itself suspends on
+// the scheduler.
+template <typename Yielded>
+class AsyncGenerator {
+ public:
+  class promise_type;
+
+ private:
+  using handle_type = std::coroutine_handle<promise_type>;
+  handle_type m_coro_handle;
+
+  explicit AsyncGenerator(promise_type &p)
+      : m_coro_handle{handle_type::from_promise(p)} {}
+
+ public:
+  AsyncGenerator(const AsyncGenerator &) = delete;
+  AsyncGenerator(AsyncGenerator &&other) noexcept
+      : m_coro_handle{std::exchange(other.m_coro_handle, nullptr)} {}
+  void swap(AsyncGenerator &other) noexcept {
+    std::swap(m_coro_handle, other.m_coro_handle);
+  }
+  AsyncGenerator &operator=(AsyncGenerator other) noexcept {
+    other.swap(*this);
+    return *this;
+  }
+  ~AsyncGenerator() {
+    if (m_coro_handle)
+      m_coro_handle.destroy();
+  }
+
+  class iterator;
+
+  iterator begin() noexcept {
+    return iterator{m_coro_handle};
+  }
+};
+
+template <typename Yielded>
+class AsyncGenerator<Yielded>::promise_type {
+ private:
+  std::optional<Yielded> m_value{};
+  std::exception_ptr m_exception;
+  std::coroutine_handle<> m_consumer;
+
+  friend class iterator;
+
+  struct transfer_to_consumer {
+    bool await_ready() const noexcept {
+      return false;
+    }
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+      return handle.promise().m_consumer;
+    }
+    void await_resume() const noexcept {}
+  };
+
+ public:
+  AsyncGenerator<Yielded> get_return_object() noexcept {
+    return AsyncGenerator{*this};
+  }
+
+  std::suspend_always initial_suspend() const noexcept {
+    return {};
+  }
+
+  transfer_to_consumer final_suspend() const noexcept {
+    return {};
+  }
+
+  void unhandled_exception() noexcept(
+      std::is_nothrow_copy_assignable_v<std::exception_ptr>) {
+    m_exception = std::current_exception();
+  }
+
+  template <std::convertible_to<Yielded> Type = Yielded>
+  transfer_to_consumer yield_value(Type &&val) {
+    m_value.emplace(std::forward<Type>(val));
+    return {};
+  }
+
+  void return_void() const noexcept {}
+
+  [[nodiscard]] Yielded const &get_value() const noexcept {
+    return *m_value;
+  }
+};
+
+template <typename Yielded>
+class AsyncGenerator<Yielded>::iterator {
+ private:
+  handle_type m_coro_handle;
+
+ public:
+  using value_type = Yielded;
+  using reference = Yielded const &;
+
+  explicit iterator(handle_type handle) noexcept : m_coro_handle{handle} {}
+
+  // Resumes the producer until its next co_yield. The result is false once
+  // the producer has returned; an exception thrown by the producer is
+  // rethrown here.
+  auto next() noexcept {
+    struct awaiter {
+      handle_type producer;
+
+      bool await_ready() const noexcept {
+        return producer.done();
+      }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> consumer) const noexcept {
+        auto &promise = producer.promise();
+        promise.m_value.reset();
+        promise.m_consumer = consumer;
+        return producer;
+      }
+      bool await_resume() const {
+        if (!producer.done())
+          return true;
+        if (auto &e = producer.promise().m_exception)
+          std::rethrow_exception(std::exchange(e, nullptr));
+        return false;
+      }
+    };
+    return awaiter{m_coro_handle};
+  }
+
+  reference operator*() const noexcept {
+    return m_coro_handle.promise().get_value();
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_ASYNC_GENERATOR_HPP
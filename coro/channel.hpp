@@ -0,0 +1,243 @@
+#ifndef GKXX_CORO_CHANNEL_HPP
+#define GKXX_CORO_CHANNEL_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "scheduler.hpp"
+
+namespace gkxx {
+
+namespace detail {
+
+  // Scheduler::post() may only be called from the thread that runs
+  // schedule(), so the tasks on both ends of a channel run there too and
+  // the channel needs no lock.
+  template <typename Executor>
+  struct channel_mutex {
+    using type = std::mutex;
+  };
+  template <>
+  struct channel_mutex<Scheduler> {
+    struct type {
+      void lock() noexcept {}
+      void unlock() noexcept {}
+    };
+  };
+
+} // namespace detail
+
+// Bounded channel between tasks running on `Executor`, which resumes the
+// tasks that a send or recv unblocks through its post(). A sender blocks
+// while the buffer holds `capacity` values (capacity 0 makes every send a
+// rendezvous); a receiver blocks while it is empty. A value sent while a
+// receiver is waiting goes straight to it, bypassing the buffer.
+//
+// Every waiter is the awaiter itself, linked into the channel's wait list
+// from the suspended coroutine's frame, so waiting allocates nothing; the
+// buffer is allocated once, up front.
+template <typename Type, typename Executor = Scheduler>
+class Channel {
+  struct waiter {
+    waiter *next = nullptr;
+    std::coroutine_handle<> handle{};
+  };
+
+  // Intrusive FIFO of waiters.
+  template <typename Waiter>
+  struct wait_list {
+    Waiter *head = nullptr;
+    Waiter *tail = nullptr;
+
+    bool empty() const noexcept {
+      return !head;
+    }
+    void push(Waiter *w) noexcept {
+      w->next = nullptr;
+      if (tail)
+        tail->next = w;
+      else
+        head = w;
+      tail = w;
+    }
+    Waiter *pop() noexcept {
+      auto w = head;
+      head = static_cast<Waiter *>(w->next);
+      if (!head)
+        tail = nullptr;
+      return w;
+    }
+  };
+
+ public:
+  class send_awaiter;
+  class recv_awaiter;
+
+ private:
+  Executor &m_executor;
+  typename detail::channel_mutex<Executor>::type m_mutex;
+  const std::size_t m_capacity;
+  std::unique_ptr<std::optional<Type>[]> m_buffer;
+  std::size_t m_head = 0;
+  std::size_t m_size = 0;
+  wait_list<send_awaiter> m_senders{};
+  wait_list<recv_awaiter> m_receivers{};
+  bool m_closed = false;
+
+  void push_buffer(Type &&value) {
+    auto tail = m_head + m_size;
+    if (tail >= m_capacity)
+      tail -= m_capacity;
+    m_buffer[tail].emplace(std::move(value));
+    ++m_size;
+  }
+  Type pop_buffer() {
+    auto &slot = m_buffer[m_head];
+    Type ret = std::move(*slot);
+    slot.reset();
+    if (++m_head == m_capacity)
+      m_head = 0;
+    --m_size;
+    return ret;
+  }
+
+ public:
+  class [[nodiscard]] send_awaiter : waiter {
+    friend class Channel;
+    friend struct wait_list<send_awaiter>;
+
+    Channel &m_channel;
+    Type m_value;
+    bool m_sent = false;
+
+    send_awaiter(Channel &channel, Type &&value)
+        : m_channel{channel}, m_value{std::move(value)} {}
+
+   public:
+    bool await_ready() const noexcept {
+      return false;
+    }
+    bool await_suspend(std::coroutine_handle<> handle) {
+      auto &ch = m_channel;
+      std::unique_lock lock{ch.m_mutex};
+      if (ch.m_closed)
+        return false;
+      if (!ch.m_receivers.empty()) {
+        auto receiver = ch.m_receivers.pop();
+        receiver->m_value.emplace(std::move(m_value));
+        m_sent = true;
+        lock.unlock();
+        ch.m_executor.post(receiver->handle);
+        return false;
+      }
+      if (ch.m_size < ch.m_capacity) {
+        ch.push_buffer(std::move(m_value));
+        m_sent = true;
+        return false;
+      }
+      this->handle = handle;
+      ch.m_senders.push(this);
+      return true;
+    }
+    // Returns false if the channel was closed before the value got in.
+    bool await_resume() const noexcept {
+      return m_sent;
+    }
+  };
+
+  class [[nodiscard]] recv_awaiter : waiter {
+    friend class Channel;
+    friend struct wait_list<recv_awaiter>;
+
+    Channel &m_channel;
+    std::optional<Type> m_value{};
+
+    explicit recv_awaiter(Channel &channel) noexcept : m_channel{channel} {}
+
+   public:
+    bool await_ready() const noexcept {
+      return false;
+    }
+    bool await_suspend(std::coroutine_handle<> handle) {
+      auto &ch = m_channel;
+      std::unique_lock lock{ch.m_mutex};
+      if (ch.m_size != 0) {
+        m_value.emplace(ch.pop_buffer());
+        // Room for the first blocked sender.
+        if (!ch.m_senders.empty()) {
+          auto sender = ch.m_senders.pop();
+          ch.push_buffer(std::move(sender->m_value));
+          sender->m_sent = true;
+          lock.unlock();
+          ch.m_executor.post(sender->handle);
+        }
+        return false;
+      }
+      if (!ch.m_senders.empty()) {
+        auto sender = ch.m_senders.pop();
+        m_value.emplace(std::move(sender->m_value));
+        sender->m_sent = true;
+        lock.unlock();
+        ch.m_executor.post(sender->handle);
+        return false;
+      }
+      if (ch.m_closed)
+        return false;
+      this->handle = handle;
+      ch.m_receivers.push(this);
+      return true;
+    }
+    // std::nullopt once the channel is closed and drained.
+    std::optional<Type> await_resume() noexcept(
+        std::is_nothrow_move_constructible_v<Type>) {
+      return std::move(m_value);
+    }
+  };
+
+  explicit Channel(Executor &executor, std::size_t capacity = 0)
+      : m_executor{executor}, m_capacity{capacity},
+        m_buffer{std::make_unique<std::optional<Type>[]>(capacity)} {}
+
+  Channel(const Channel &) = delete;
+  Channel &operator=(const Channel &) = delete;
+
+  // co_await ch.send(v) yields false if the channel has been closed.
+  send_awaiter send(Type value) {
+    return send_awaiter{*this, std::move(value)};
+  }
+  // co_await ch.recv() yields std::nullopt once the channel has been closed
+  // and every buffered value has been received.
+  recv_awaiter recv() noexcept {
+    return recv_awaiter{*this};
+  }
+
+  // Fails the blocked senders and wakes the blocked receivers. Values
+  // already buffered can still be received.
+  void close() {
+    wait_list<send_awaiter> senders;
+    wait_list<recv_awaiter> receivers;
+    {
+      std::lock_guard lock{m_mutex};
+      m_closed = true;
+      senders = std::exchange(m_senders, {});
+      receivers = std::exchange(m_receivers, {});
+    }
+    while (!senders.empty())
+      m_executor.post(senders.pop()->handle);
+    while (!receivers.empty())
+      m_executor.post(receivers.pop()->handle);
+  }
+
+  std::size_t capacity() const noexcept {
+    return m_capacity;
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_CHANNEL_HPP
@@ -0,0 +1,126 @@
+#ifndef GKXX_CORO_CHASE_LEV_DEQUE_HPP
+#define GKXX_CORO_CHASE_LEV_DEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace gkxx {
+
+// Chase-Lev work-stealing deque, with the memory orderings of Le et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP'13).
+// The owner pushes and pops at the bottom (LIFO), any other thread steals
+// from the top (FIFO). Arrays outgrown by the owner are kept until the deque
+// is destroyed, because a thief may still be reading from them.
+template <typename Type>
+class ChaseLevDeque {
+  static_assert(std::is_trivially_copyable_v<Type>);
+
+  struct array {
+    std::int64_t capacity;
+    std::unique_ptr<std::atomic<Type>[]> buffer;
+
+    explicit array(std::int64_t cap)
+        : capacity{cap}, buffer{std::make_unique<std::atomic<Type>[]>(
+                             static_cast<std::size_t>(cap))} {}
+
+    Type get(std::int64_t i) const noexcept {
+      return buffer[static_cast<std::size_t>(i & (capacity - 1))].load(
+          std::memory_order_relaxed);
+    }
+    void put(std::int64_t i, Type x) noexcept {
+      buffer[static_cast<std::size_t>(i & (capacity - 1))].store(
+          x, std::memory_order_relaxed);
+    }
+  };
+
+  alignas(64) std::atomic<std::int64_t> m_top{0};
+  alignas(64) std::atomic<std::int64_t> m_bottom{0};
+  std::atomic<array *> m_array;
+  std::vector<std::unique_ptr<array>> m_arrays;
+
+  array *grow(array *old, std::int64_t bottom, std::int64_t top) {
+    auto bigger = std::make_unique<array>(old->capacity * 2);
+    for (auto i = top; i != bottom; ++i)
+      bigger->put(i, old->get(i));
+    auto ret = bigger.get();
+    m_arrays.push_back(std::move(bigger));
+    m_array.store(ret, std::memory_order_release);
+    return ret;
+  }
+
+ public:
+  explicit ChaseLevDeque(std::int64_t capacity = 256) {
+    std::int64_t cap = 1;
+    while (cap < capacity)
+      cap *= 2;
+    m_arrays.push_back(std::make_unique<array>(cap));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+  }
+
+  ChaseLevDeque(const ChaseLevDeque &) = delete;
+  ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+  // owner only
+  void push(Type x) {
+    auto b = m_bottom.load(std::memory_order_relaxed);
+    auto t = m_top.load(std::memory_order_acquire);
+    auto a = m_array.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1)
+      a = grow(a, b, t);
+    a->put(b, x);
+    m_bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // owner only
+  std::optional<Type> pop() {
+    auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+    auto a = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = m_top.load(std::memory_order_relaxed);
+    if (t > b) {
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    auto x = a->get(b);
+    if (t == b) {
+      // Last element: race against thieves for it.
+      bool won = m_top.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      if (!won)
+        return std::nullopt;
+    }
+    return x;
+  }
+
+  // any thread
+  std::optional<Type> steal() {
+    auto t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b)
+      return std::nullopt;
+    auto a = m_array.load(std::memory_order_acquire);
+    auto x = a->get(t);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+      return std::nullopt;
+    return x;
+  }
+
+  std::int64_t size() const noexcept {
+    auto b = m_bottom.load(std::memory_order_relaxed);
+    auto t = m_top.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_CHASE_LEV_DEQUE_HPP
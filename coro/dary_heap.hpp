@@ -0,0 +1,99 @@
+#ifndef GKXX_CORO_DARY_HEAP_HPP
+#define GKXX_CORO_DARY_HEAP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace gkxx {
+
+// Min-heap with `Arity` children per node, stored in one vector. With four
+// children a node's children share a cache line or two and the tree is half
+// as deep as a binary heap, which pays off on the sift-down of every pop.
+template <typename Type, typename Compare = std::less<>,
+          std::size_t Arity = 4>
+class DaryHeap {
+  static_assert(Arity >= 2);
+
+  std::vector<Type> m_data;
+  [[no_unique_address]] Compare m_less{};
+
+  static constexpr std::size_t parent(std::size_t i) noexcept {
+    return (i - 1) / Arity;
+  }
+  static constexpr std::size_t first_child(std::size_t i) noexcept {
+    return i * Arity + 1;
+  }
+
+  void sift_up(std::size_t i) {
+    auto value = std::move(m_data[i]);
+    while (i != 0) {
+      auto p = parent(i);
+      if (!m_less(value, m_data[p]))
+        break;
+      m_data[i] = std::move(m_data[p]);
+      i = p;
+    }
+    m_data[i] = std::move(value);
+  }
+
+  void sift_down(std::size_t i) {
+    auto n = m_data.size();
+    auto value = std::move(m_data[i]);
+    while (true) {
+      auto c = first_child(i);
+      if (c >= n)
+        break;
+      auto last = c + Arity < n ? c + Arity : n;
+      auto best = c;
+      for (++c; c != last; ++c)
+        if (m_less(m_data[c], m_data[best]))
+          best = c;
+      if (!m_less(m_data[best], value))
+        break;
+      m_data[i] = std::move(m_data[best]);
+      i = best;
+    }
+    m_data[i] = std::move(value);
+  }
+
+ public:
+  DaryHeap() = default;
+  explicit DaryHeap(Compare less) : m_less{std::move(less)} {}
+
+  bool empty() const noexcept {
+    return m_data.empty();
+  }
+  std::size_t size() const noexcept {
+    return m_data.size();
+  }
+  void reserve(std::size_t n) {
+    m_data.reserve(n);
+  }
+
+  const Type &top() const noexcept {
+    return m_data.front();
+  }
+
+  void push(Type value) {
+    m_data.push_back(std::move(value));
+    sift_up(m_data.size() - 1);
+  }
+
+  Type pop() {
+    auto ret = std::move(m_data.front());
+    if (m_data.size() > 1) {
+      m_data.front() = std::move(m_data.back());
+      m_data.pop_back();
+      sift_down(0);
+    } else {
+      m_data.pop_back();
+    }
+    return ret;
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_DARY_HEAP_HPP
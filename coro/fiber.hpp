@@ -0,0 +1,484 @@
+#ifndef GKXX_CORO_FIBER_HPP
+#define GKXX_CORO_FIBER_HPP
+
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "scheduler.hpp"
+#include "task.hpp"
+
+// Context switch: saves the callee-saved registers on the current stack,
+// stores the stack pointer to *save_sp, switches to load_sp and restores
+// the registers saved there. The symbols are weak, so every translation
+// unit can carry the definition.
+extern "C" void gkxx_fiber_switch(void **save_sp, void *load_sp) noexcept;
+extern "C" void gkxx_fiber_entry() noexcept;
+
+#if defined(__x86_64__)
+// A fresh stack starts with r12 = argument, r13 = function; the return
+// address leads to gkxx_fiber_entry, which calls function(argument) with
+// the stack aligned as after a call. MXCSR and the x87 control word are
+// part of the context as well.
+asm(R"(
+  .text
+  .weak gkxx_fiber_switch
+  .type gkxx_fiber_switch, @function
+gkxx_fiber_switch:
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  subq $8, %rsp
+  stmxcsr (%rsp)
+  fnstcw 4(%rsp)
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  ldmxcsr (%rsp)
+  fldcw 4(%rsp)
+  addq $8, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  ret
+  .size gkxx_fiber_switch, .-gkxx_fiber_switch
+
+  .weak gkxx_fiber_entry
+  .type gkxx_fiber_entry, @function
+gkxx_fiber_entry:
+  movq %r12, %rdi
+  callq *%r13
+  ud2
+  .size gkxx_fiber_entry, .-gkxx_fiber_entry
+)");
+#elif defined(__aarch64__)
+// x19 = argument, x20 = function, x30 = gkxx_fiber_entry on a fresh stack.
+asm(R"(
+  .text
+  .weak gkxx_fiber_switch
+  .type gkxx_fiber_switch, %function
+gkxx_fiber_switch:
+  sub sp, sp, #160
+  stp x19, x20, [sp, #0]
+  stp x21, x22, [sp, #16]
+  stp x23, x24, [sp, #32]
+  stp x25, x26, [sp, #48]
+  stp x27, x28, [sp, #64]
+  stp x29, x30, [sp, #80]
+  stp d8, d9, [sp, #96]
+  stp d10, d11, [sp, #112]
+  stp d12, d13, [sp, #128]
+  stp d14, d15, [sp, #144]
+  mov x2, sp
+  str x2, [x0]
+  mov sp, x1
+  ldp x19, x20, [sp, #0]
+  ldp x21, x22, [sp, #16]
+  ldp x23, x24, [sp, #32]
+  ldp x25, x26, [sp, #48]
+  ldp x27, x28, [sp, #64]
+  ldp x29, x30, [sp, #80]
+  ldp d8, d9, [sp, #96]
+  ldp d10, d11, [sp, #112]
+  ldp d12, d13, [sp, #128]
+  ldp d14, d15, [sp, #144]
+  add sp, sp, #160
+  ret
+  .size gkxx_fiber_switch, .-gkxx_fiber_switch
+
+  .weak gkxx_fiber_entry
+  .type gkxx_fiber_entry, %function
+gkxx_fiber_entry:
+  mov x0, x19
+  blr x20
+  brk #0
+  .size gkxx_fiber_entry, .-gkxx_fiber_entry
+)");
+#else
+#error "fiber.hpp supports x86-64 and aarch64 only"
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+namespace gkxx {
+
+// Per-thread cache of fiber stacks. Stacks are carved out of slabs mapped
+// with mmap, each with a PROT_NONE guard page below it so that an overflow
+// faults instead of corrupting the neighbour; released stacks go back on a
+// free list and are only unmapped with the pool. Every guard page splits a
+// mapping, so a process needs two entries of vm.max_map_count per guarded
+// stack; pass `guard = false` to go beyond that.
+class FiberStackPool {
+  // A free stack links to the next one through the word below its top.
+  struct free_stack {
+    free_stack *next;
+  };
+
+  std::size_t m_stack_size;
+  std::size_t m_guard_size;
+  std::size_t m_per_slab;
+  std::vector<std::pair<void *, std::size_t>> m_slabs;
+  free_stack *m_free = nullptr;
+
+  static std::size_t page_size() noexcept {
+    static const auto ret = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return ret;
+  }
+  static free_stack *link_of(void *top) noexcept {
+    return static_cast<free_stack *>(top) - 1;
+  }
+
+  void add_slab() {
+    auto stride = m_guard_size + m_stack_size;
+    auto length = stride * m_per_slab;
+    auto slab = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (slab == MAP_FAILED)
+      throw std::bad_alloc{};
+    m_slabs.emplace_back(slab, length);
+    for (std::size_t i = m_per_slab; i-- != 0;) {
+      auto bottom = static_cast<char *>(slab) + i * stride;
+      if (m_guard_size != 0 && ::mprotect(bottom, m_guard_size, PROT_NONE))
+        throw std::bad_alloc{};
+      auto top = bottom + stride;
+      link_of(top)->next = m_free;
+      m_free = link_of(top);
+    }
+  }
+
+ public:
+  static constexpr std::size_t default_stack_size = 64 * 1024;
+
+  explicit FiberStackPool(std::size_t stack_size = default_stack_size,
+                          bool guard = true, std::size_t stacks_per_slab = 64)
+      : m_stack_size{(stack_size + page_size() - 1) / page_size() *
+                     page_size()},
+        m_guard_size{guard ? page_size() : 0},
+        m_per_slab{stacks_per_slab == 0 ? 1 : stacks_per_slab} {}
+
+  FiberStackPool(const FiberStackPool &) = delete;
+  FiberStackPool &operator=(const FiberStackPool &) = delete;
+
+  // Every stack has to be back by now.
+  ~FiberStackPool() {
+    for (auto [slab, length] : m_slabs)
+      ::munmap(slab, length);
+  }
+
+  // The pool behind spawn_fiber() calls that do not name one.
+  static FiberStackPool &local() {
+    thread_local FiberStackPool ret;
+    return ret;
+  }
+
+  std::size_t stack_size() const noexcept {
+    return m_stack_size;
+  }
+
+  // Returns the top of a stack of stack_size() bytes.
+  void *allocate() {
+    if (!m_free)
+      add_slab();
+    auto stack = std::exchange(m_free, m_free->next);
+    return stack + 1;
+  }
+  void deallocate(void *top) noexcept {
+    auto stack = link_of(top);
+    stack->next = m_free;
+    m_free = stack;
+  }
+};
+
+namespace detail {
+
+  template <typename Awaitable>
+  decltype(auto) get_awaiter(Awaitable &&awaitable) {
+    if constexpr (requires {
+                    std::forward<Awaitable>(awaitable).operator co_await();
+                  })
+      return std::forward<Awaitable>(awaitable).operator co_await();
+    else if constexpr (requires {
+                         operator co_await(
+                             std::forward<Awaitable>(awaitable));
+                       })
+      return operator co_await(std::forward<Awaitable>(awaitable));
+    else
+      return static_cast<Awaitable &>(awaitable);
+  }
+
+  template <typename Awaitable>
+  using await_result_t =
+      decltype(get_awaiter(std::declval<Awaitable>()).await_resume());
+
+  // Bookkeeping of a fiber, placed at the top of its own stack. The fiber
+  // is driven by a small stackless task on the Scheduler's run queue:
+  // resuming the task switches to the fiber, and when the fiber switches
+  // back the task either requeues itself (yield) or awaits `pending` on
+  // the fiber's behalf.
+  class fiber_base {
+    void *m_sp;
+    void *m_driver_sp = nullptr;
+    void *m_stack_top;
+    FiberStackPool &m_pool;
+    Scheduler &m_scheduler;
+    Task<> m_pending{};
+    bool m_finished = false;
+    void (*m_run)(fiber_base &);
+    void (*m_destroy)(fiber_base &) noexcept;
+#if defined(__SANITIZE_ADDRESS__)
+    void *m_fake_stack = nullptr;
+    const void *m_driver_stack_bottom = nullptr;
+    std::size_t m_driver_stack_size = 0;
+#endif
+
+    static inline thread_local fiber_base *tl_current = nullptr;
+
+    template <typename>
+    friend class fiber;
+    friend fiber_base &current_fiber() noexcept;
+
+    fiber_base(void *stack_top, FiberStackPool &pool, Scheduler &scheduler,
+               void (*run)(fiber_base &),
+               void (*destroy)(fiber_base &) noexcept) noexcept
+        : m_stack_top{stack_top}, m_pool{pool}, m_scheduler{scheduler},
+          m_run{run}, m_destroy{destroy} {
+      // Initial frame for gkxx_fiber_switch to pop, right below this
+      // object.
+      auto top = reinterpret_cast<std::uintptr_t>(this) & ~std::uintptr_t{15};
+      auto frame = reinterpret_cast<std::uint64_t *>(top);
+#if defined(__x86_64__)
+      *--frame = reinterpret_cast<std::uint64_t>(&gkxx_fiber_entry);
+      *--frame = 0;                                          // rbp
+      *--frame = 0;                                          // rbx
+      *--frame = reinterpret_cast<std::uint64_t>(this);      // r12
+      *--frame = reinterpret_cast<std::uint64_t>(&entry);    // r13
+      *--frame = 0;                                          // r14
+      *--frame = 0;                                          // r15
+      *--frame = 0x037f'0000'1f80;  // x87 control word, MXCSR
+#else
+      frame -= 20;
+      for (int i = 0; i != 20; ++i)
+        frame[i] = 0;
+      frame[0] = reinterpret_cast<std::uint64_t>(this);      // x19
+      frame[1] = reinterpret_cast<std::uint64_t>(&entry);    // x20
+      frame[11] = reinterpret_cast<std::uint64_t>(&gkxx_fiber_entry); // x30
+#endif
+      m_sp = frame;
+    }
+
+    void *stack_bottom() const noexcept {
+      return static_cast<char *>(m_stack_top) - m_pool.stack_size();
+    }
+
+    static void entry(void *self) noexcept {
+      auto &fiber = *static_cast<fiber_base *>(self);
+#if defined(__SANITIZE_ADDRESS__)
+      __sanitizer_finish_switch_fiber(nullptr, &fiber.m_driver_stack_bottom,
+                                      &fiber.m_driver_stack_size);
+#endif
+      // Like std::thread, an exception escaping the fiber terminates.
+      fiber.m_run(fiber);
+      fiber.m_finished = true;
+      fiber.switch_to_driver();
+    }
+
+    // Runs the fiber until it switches back.
+    void switch_to_fiber() noexcept {
+      auto previous = std::exchange(tl_current, this);
+#if defined(__SANITIZE_ADDRESS__)
+      void *fake_stack = nullptr;
+      __sanitizer_start_switch_fiber(&fake_stack, stack_bottom(),
+                                     m_pool.stack_size());
+#endif
+      gkxx_fiber_switch(&m_driver_sp, m_sp);
+#if defined(__SANITIZE_ADDRESS__)
+      __sanitizer_finish_switch_fiber(fake_stack, nullptr, nullptr);
+#endif
+      tl_current = previous;
+    }
+    void switch_to_driver() noexcept {
+#if defined(__SANITIZE_ADDRESS__)
+      __sanitizer_start_switch_fiber(m_finished ? nullptr : &m_fake_stack,
+                                     m_driver_stack_bottom,
+                                     m_driver_stack_size);
+#endif
+      gkxx_fiber_switch(&m_sp, m_driver_sp);
+#if defined(__SANITIZE_ADDRESS__)
+      __sanitizer_finish_switch_fiber(m_fake_stack, &m_driver_stack_bottom,
+                                      &m_driver_stack_size);
+#endif
+    }
+
+   public:
+    fiber_base(const fiber_base &) = delete;
+    fiber_base &operator=(const fiber_base &) = delete;
+
+    Scheduler &scheduler() const noexcept {
+      return m_scheduler;
+    }
+
+    void yield() noexcept {
+      switch_to_driver();
+    }
+    // Has the driver await `task`, then resumes the fiber.
+    void await(Task<> task) noexcept {
+      m_pending = std::move(task);
+      switch_to_driver();
+    }
+
+    static Task<> drive(fiber_base &fiber) {
+      while (true) {
+        fiber.switch_to_fiber();
+        if (fiber.m_finished)
+          break;
+        if (!fiber.m_pending.is_ready())
+          co_await std::exchange(fiber.m_pending, Task<>{});
+        else
+          co_await fiber.m_scheduler.suspend();
+      }
+      auto top = fiber.m_stack_top;
+      auto &pool = fiber.m_pool;
+      fiber.m_destroy(fiber);
+      pool.deallocate(top);
+    }
+  };
+
+  template <typename Fn>
+  class fiber : public fiber_base {
+    Fn m_fn;
+
+    static void run(fiber_base &self) {
+      static_cast<fiber &>(self).m_fn();
+    }
+    static void destroy(fiber_base &self) noexcept {
+      static_cast<fiber &>(self).~fiber();
+    }
+
+   public:
+    fiber(void *stack_top, FiberStackPool &pool, Scheduler &scheduler,
+          Fn fn)
+        : fiber_base{stack_top, pool, scheduler, &run, &destroy},
+          m_fn{std::move(fn)} {}
+  };
+
+  inline fiber_base &current_fiber() noexcept {
+    assert(fiber_base::tl_current && "not running on a fiber");
+    return *fiber_base::tl_current;
+  }
+
+  template <typename Awaitable>
+  concept has_co_await_operator = requires(Awaitable &&awaitable) {
+    std::forward<Awaitable>(awaitable).operator co_await();
+  } || requires(Awaitable &&awaitable) {
+    operator co_await(std::forward<Awaitable>(awaitable));
+  };
+
+  // Awaits on behalf of a fiber. A bare awaiter is awaited as an lvalue,
+  // since GCC copies one passed as an xvalue.
+  template <typename Awaitable, typename Storage>
+  Task<> await_for_fiber(std::remove_reference_t<Awaitable> &awaitable,
+                         Storage &result, std::exception_ptr &exception) {
+    try {
+      if constexpr (!has_co_await_operator<Awaitable>) {
+        if constexpr (std::is_void_v<await_result_t<Awaitable>>)
+          co_await awaitable;
+        else
+          result.emplace(co_await awaitable);
+      } else if constexpr (std::is_void_v<await_result_t<Awaitable>>) {
+        co_await std::forward<Awaitable>(awaitable);
+      } else {
+        result.emplace(co_await std::forward<Awaitable>(awaitable));
+      }
+    } catch (...) {
+      exception = std::current_exception();
+    }
+  }
+
+} // namespace detail
+
+// Starts `fn()` on a stack of its own, for code that cannot be turned into
+// coroutines. The fiber runs on `scheduler`'s run queue next to the
+// stackless tasks, and, like them, only switches at the points below. It
+// stays on the scheduler's thread, so thread-locals are safe to use.
+template <typename Fn>
+void spawn_fiber(Scheduler &scheduler, Fn fn,
+                 FiberStackPool &pool = FiberStackPool::local()) {
+  using fiber_type = detail::fiber<std::decay_t<Fn>>;
+  static_assert(alignof(fiber_type) <= 16);
+  auto top = pool.allocate();
+  auto place = reinterpret_cast<std::uintptr_t>(top) - sizeof(fiber_type);
+  place &= ~std::uintptr_t{15};
+  // Moving `fn` in or allocating the driver's frame may throw; the stack
+  // goes back to the pool then.
+  fiber_type *fiber;
+  try {
+    fiber = ::new (reinterpret_cast<void *>(place))
+        fiber_type{top, pool, scheduler, std::move(fn)};
+  } catch (...) {
+    pool.deallocate(top);
+    throw;
+  }
+  Task<> driver;
+  try {
+    driver = detail::fiber_base::drive(*fiber);
+  } catch (...) {
+    fiber->~fiber_type();
+    pool.deallocate(top);
+    throw;
+  }
+  scheduler.spawn(std::move(driver));
+}
+
+namespace this_fiber {
+
+  // Requeues the calling fiber on its scheduler.
+  inline void yield() noexcept {
+    detail::current_fiber().yield();
+  }
+
+  // Blocks the calling fiber until `awaitable` completes (anything a
+  // coroutine could co_await: sleep_for(), a Task, a channel's recv(), ...)
+  // and returns its result. Other tasks and fibers keep running meanwhile.
+  template <typename Awaitable>
+  auto await(Awaitable &&awaitable) {
+    using result_type = detail::await_result_t<Awaitable>;
+    using storage = std::conditional_t<
+        std::is_void_v<result_type>, std::optional<std::monostate>,
+        std::optional<std::remove_cvref_t<result_type>>>;
+    storage result;
+    std::exception_ptr exception;
+    detail::current_fiber().await(
+        detail::await_for_fiber<Awaitable>(awaitable, result, exception));
+    if (exception)
+      std::rethrow_exception(exception);
+    if constexpr (!std::is_void_v<result_type>)
+      return std::move(*result);
+  }
+
+  inline Scheduler &scheduler() noexcept {
+    return detail::current_fiber().scheduler();
+  }
+
+} // namespace this_fiber
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_FIBER_HPP
@@ -0,0 +1,467 @@
+#ifndef GKXX_CORO_FILE_IO_HPP
+#define GKXX_CORO_FILE_IO_HPP
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "io_uring.hpp"
+#include "reactor.hpp"
+#include "scheduler.hpp"
+
+namespace gkxx {
+
+enum class FileIoBackend { automatic, io_uring, thread_pool };
+
+// Index into the table passed to FileIo::register_files().
+struct FixedFile {
+  unsigned index;
+};
+
+struct FileIoStats {
+  std::uint64_t operations = 0;
+  // io_uring_enter calls, or hand-overs to the thread pool.
+  std::uint64_t submit_calls = 0;
+  // Times the reactor woke up for completions (one epoll_wait plus one
+  // eventfd read each).
+  std::uint64_t wakeups = 0;
+};
+
+class FileIo;
+
+namespace detail {
+
+  struct file_operation {
+    enum class kind : unsigned char { read, write };
+
+    FileIo &io;
+    kind op;
+    bool fixed_file;
+    int fd;
+    int buffer_index;
+    void *data;
+    std::size_t size;
+    std::uint64_t offset;
+    std::coroutine_handle<> handle{};
+    // Bytes transferred, or -errno.
+    std::int64_t result = 0;
+    file_operation *next = nullptr;
+
+    file_operation(FileIo &io, kind op, bool fixed_file, int fd,
+                   int buffer_index, void *data, std::size_t size,
+                   std::uint64_t offset) noexcept
+        : io{io}, op{op}, fixed_file{fixed_file}, fd{fd},
+          buffer_index{buffer_index}, data{data}, size{size},
+          offset{offset} {}
+    file_operation(const file_operation &) = delete;
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle);
+    std::size_t await_resume() const {
+      if (result < 0)
+        throw std::system_error(static_cast<int>(-result),
+                                std::system_category(),
+                                op == kind::read ? "file read" : "file write");
+      return static_cast<std::size_t>(result);
+    }
+  };
+
+  // Intrusive FIFO of operations; an operation is in at most one list.
+  struct operation_list {
+    file_operation *head = nullptr;
+    file_operation **tail = &head;
+
+    operation_list() = default;
+    operation_list(const operation_list &) = delete;
+    operation_list &operator=(const operation_list &) = delete;
+
+    bool empty() const noexcept {
+      return head == nullptr;
+    }
+    void push(file_operation &op) noexcept {
+      op.next = nullptr;
+      *tail = &op;
+      tail = &op.next;
+    }
+    file_operation *pop() noexcept {
+      auto ret = head;
+      if (ret && !(head = ret->next))
+        tail = &head;
+      return ret;
+    }
+    void splice(operation_list &other) noexcept {
+      if (other.empty())
+        return;
+      *tail = other.head;
+      tail = other.tail;
+      other.head = nullptr;
+      other.tail = &other.head;
+    }
+  };
+
+  // Fallback backend: blocking pread/pwrite on a few threads, completions
+  // signalled through an eventfd.
+  class blocking_io_pool {
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    operation_list m_queue;
+    bool m_stop = false;
+    std::mutex m_done_mutex;
+    operation_list m_done;
+    int m_event_fd;
+    std::vector<std::thread> m_threads;
+
+    static void perform(file_operation &op) noexcept {
+      while (true) {
+        auto n = op.op == file_operation::kind::read
+                     ? ::pread(op.fd, op.data, op.size,
+                               static_cast<off_t>(op.offset))
+                     : ::pwrite(op.fd, op.data, op.size,
+                                static_cast<off_t>(op.offset));
+        if (n < 0 && errno == EINTR)
+          continue;
+        op.result = n < 0 ? -errno : n;
+        return;
+      }
+    }
+
+    void worker() {
+      while (true) {
+        file_operation *op;
+        {
+          std::unique_lock lock{m_mutex};
+          m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+          if (m_queue.empty())
+            return;
+          op = m_queue.pop();
+        }
+        perform(*op);
+        {
+          std::lock_guard lock{m_done_mutex};
+          m_done.push(*op);
+        }
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto r = ::write(m_event_fd, &one, sizeof(one));
+      }
+    }
+
+   public:
+    blocking_io_pool(std::size_t threads, int event_fd) : m_event_fd{event_fd} {
+      for (std::size_t i = 0; i != threads; ++i)
+        m_threads.emplace_back([this] { worker(); });
+    }
+    ~blocking_io_pool() {
+      {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+      }
+      m_cv.notify_all();
+      for (auto &t : m_threads)
+        t.join();
+    }
+
+    void submit(operation_list &ops) {
+      {
+        std::lock_guard lock{m_mutex};
+        m_queue.splice(ops);
+      }
+      m_cv.notify_all();
+    }
+
+    template <typename F>
+    void reap(F &&f) {
+      operation_list done;
+      {
+        std::lock_guard lock{m_done_mutex};
+        done.splice(m_done);
+      }
+      while (auto op = done.pop())
+        f(*op);
+    }
+  };
+
+} // namespace detail
+
+// Asynchronous file reads and writes for the tasks of a Scheduler.
+//
+// With io_uring, awaiting an operation only fills an SQE. The SQEs of all
+// tasks that suspended since the scheduler last polled are submitted with
+// one io_uring_enter; completions that are already there (e.g. page cache
+// hits) are reaped right away, the rest are signalled through an eventfd
+// watched by the scheduler's reactor and reaped in bulk. Without io_uring,
+// the operations are handed to a small thread pool in the same batches.
+//
+// An operation must not be abandoned: do not destroy a task while it waits
+// for one, and keep the FileIo alive until all of them have completed.
+class FileIo {
+  using file_operation = detail::file_operation;
+
+  Scheduler &m_scheduler;
+  int m_event_fd;
+  std::unique_ptr<IoUring> m_ring;
+  std::unique_ptr<detail::blocking_io_pool> m_pool;
+  std::vector<int> m_fixed_files;
+  // Waits on m_event_fd while operations are outstanding.
+  struct drain_operation : IoOperation {
+    FileIo *owner;
+  } m_drain{{&drain_completions}, this};
+  struct batcher : IoBatcher {
+    FileIo *owner;
+  } m_batcher{{&flush_submissions}, this};
+  bool m_drain_waiting = false;
+  // Not yet given to the kernel or the pool.
+  detail::operation_list m_pending;
+  std::size_t m_unsubmitted = 0;
+  std::size_t m_in_flight = 0;
+  std::size_t m_outstanding = 0;
+  FileIoStats m_stats;
+
+  friend struct detail::file_operation;
+
+  void complete(file_operation &op) {
+    --m_outstanding;
+    m_scheduler.post(op.handle);
+  }
+
+  void reap() {
+    if (m_ring) {
+      m_in_flight -= m_ring->reap([this](const ::io_uring_cqe &cqe) {
+        auto &op = *reinterpret_cast<file_operation *>(cqe.user_data);
+        op.result = cqe.res;
+        complete(op);
+      });
+    } else {
+      m_pool->reap([this](file_operation &op) { complete(op); });
+    }
+  }
+
+  // Moves pending operations into the SQ ring, keeping the number in
+  // flight within the size of the CQ ring.
+  void fill_sqes() {
+    while (!m_pending.empty() &&
+           m_unsubmitted + m_in_flight < m_ring->cq_entries()) {
+      auto sqe = m_ring->get_sqe();
+      if (!sqe)
+        break;
+      auto &op = *m_pending.pop();
+      auto fixed = op.buffer_index >= 0;
+      if (op.op == file_operation::kind::read)
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+      else
+        sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+      sqe->fd = op.fd;
+      if (op.fixed_file)
+        sqe->flags |= IOSQE_FIXED_FILE;
+      sqe->addr = reinterpret_cast<std::uintptr_t>(op.data);
+      sqe->len = static_cast<unsigned>(op.size);
+      sqe->off = op.offset;
+      sqe->buf_index = fixed ? static_cast<std::uint16_t>(op.buffer_index) : 0;
+      sqe->user_data = reinterpret_cast<std::uintptr_t>(&op);
+      ++m_unsubmitted;
+    }
+  }
+
+  void stop_waiting_if_idle() noexcept {
+    if (m_outstanding == 0 && m_drain_waiting) {
+      m_scheduler.m_reactor.cancel(m_event_fd, Reactor::direction::read,
+                                   m_drain);
+      m_drain_waiting = false;
+    }
+  }
+
+  static bool flush_submissions(IoBatcher &batcher) {
+    auto &self = *static_cast<struct batcher &>(batcher).owner;
+    if (self.m_pending.empty() && self.m_unsubmitted == 0)
+      return false;
+    ++self.m_stats.submit_calls;
+    if (!self.m_ring) {
+      self.m_pool->submit(self.m_pending);
+      return false;
+    }
+    self.fill_sqes();
+    auto consumed = self.m_ring->submit();
+    self.m_unsubmitted -= consumed;
+    self.m_in_flight += consumed;
+    auto before = self.m_outstanding;
+    self.reap();
+    self.stop_waiting_if_idle();
+    return self.m_outstanding != before;
+  }
+
+  static bool drain_completions(IoOperation &op) noexcept {
+    auto &self = *static_cast<drain_operation &>(op).owner;
+    ++self.m_stats.wakeups;
+    std::uint64_t count;
+    [[maybe_unused]] auto r = ::read(self.m_event_fd, &count, sizeof(count));
+    self.reap();
+    if (self.m_ring)
+      self.fill_sqes();
+    if (self.m_outstanding != 0)
+      return false;
+    // Done: the reactor resumes this no-op handle and forgets the drain.
+    self.m_drain_waiting = false;
+    return true;
+  }
+
+  void enqueue(file_operation &op) {
+    ++m_stats.operations;
+    ++m_outstanding;
+    m_pending.push(op);
+    if (m_ring)
+      fill_sqes();
+    if (!m_drain_waiting) {
+      m_scheduler.m_reactor.wait(m_event_fd, Reactor::direction::read,
+                                 m_drain);
+      m_drain_waiting = true;
+    }
+  }
+
+  file_operation make(file_operation::kind op, int fd, std::byte *data,
+                      std::size_t size, std::uint64_t offset,
+                      int buffer_index) noexcept {
+    return {*this, op, false, fd, buffer_index, data, size, offset};
+  }
+  file_operation make(file_operation::kind op, FixedFile file,
+                      std::byte *data, std::size_t size, std::uint64_t offset,
+                      int buffer_index) {
+    if (m_ring)
+      return {*this, op,   true, static_cast<int>(file.index), buffer_index,
+              data,  size, offset};
+    return {*this, op,   false, m_fixed_files.at(file.index), buffer_index,
+            data,  size, offset};
+  }
+
+ public:
+  explicit FileIo(Scheduler &scheduler,
+                  FileIoBackend backend = FileIoBackend::automatic,
+                  unsigned entries = 256, std::size_t pool_threads = 4)
+      : m_scheduler{scheduler},
+        m_event_fd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+    if (m_event_fd < 0)
+      throw std::system_error(errno, std::system_category(), "eventfd");
+    m_drain.handle = std::noop_coroutine();
+    try {
+      if (backend != FileIoBackend::thread_pool) {
+        try {
+          m_ring = std::make_unique<IoUring>(entries);
+          // Only completions that did not happen inline in io_uring_enter
+          // need to wake the reactor.
+          try {
+            m_ring->register_resource(IORING_REGISTER_EVENTFD_ASYNC,
+                                      &m_event_fd, 1);
+          } catch (const std::system_error &) {
+            m_ring->register_resource(IORING_REGISTER_EVENTFD, &m_event_fd,
+                                      1);
+          }
+        } catch (const std::system_error &) {
+          if (backend == FileIoBackend::io_uring)
+            throw;
+          m_ring.reset();
+        }
+      }
+      if (!m_ring)
+        m_pool = std::make_unique<detail::blocking_io_pool>(pool_threads,
+                                                             m_event_fd);
+      scheduler.m_reactor.add(m_event_fd);
+    } catch (...) {
+      m_pool.reset();
+      m_ring.reset();
+      ::close(m_event_fd);
+      throw;
+    }
+    scheduler.m_reactor.add_batcher(m_batcher);
+  }
+
+  FileIo(const FileIo &) = delete;
+  FileIo &operator=(const FileIo &) = delete;
+
+  ~FileIo() {
+    m_scheduler.m_reactor.remove_batcher(m_batcher);
+    m_scheduler.m_reactor.remove(m_event_fd);
+    m_pool.reset();
+    m_ring.reset();
+    ::close(m_event_fd);
+  }
+
+  bool uses_io_uring() const noexcept {
+    return m_ring != nullptr;
+  }
+  const FileIoStats &stats() const noexcept {
+    return m_stats;
+  }
+
+  // Registered buffers save the kernel from mapping user memory on every
+  // operation; use them with read_fixed() and write_fixed(). Ignored by the
+  // thread pool.
+  void register_buffers(std::span<const ::iovec> buffers) {
+    if (m_ring)
+      m_ring->register_resource(IORING_REGISTER_BUFFERS, buffers.data(),
+                                static_cast<unsigned>(buffers.size()));
+  }
+  // Registered files save the kernel a file table lookup per operation;
+  // refer to them through FixedFile{index}.
+  void register_files(std::span<const int> fds) {
+    if (m_ring)
+      m_ring->register_resource(IORING_REGISTER_FILES, fds.data(),
+                                static_cast<unsigned>(fds.size()));
+    m_fixed_files.assign(fds.begin(), fds.end());
+  }
+
+  // co_await read(file, buffer, offset) and write(...) yield the number of
+  // bytes transferred and throw std::system_error on failure. `file` is a
+  // file descriptor or a FixedFile.
+  template <typename File>
+  file_operation read(File file, std::span<std::byte> buffer,
+                      std::uint64_t offset) {
+    return make(file_operation::kind::read, file, buffer.data(), buffer.size(),
+                offset, -1);
+  }
+  template <typename File>
+  file_operation write(File file, std::span<const std::byte> buffer,
+                       std::uint64_t offset) {
+    return make(file_operation::kind::write, file,
+                const_cast<std::byte *>(buffer.data()), buffer.size(), offset,
+                -1);
+  }
+  // `buffer` must lie within registered buffer number `buffer_index`.
+  template <typename File>
+  file_operation read_fixed(File file, std::span<std::byte> buffer,
+                            std::uint64_t offset, unsigned buffer_index) {
+    return make(file_operation::kind::read, file, buffer.data(), buffer.size(),
+                offset, m_ring ? static_cast<int>(buffer_index) : -1);
+  }
+  template <typename File>
+  file_operation write_fixed(File file, std::span<const std::byte> buffer,
+                             std::uint64_t offset, unsigned buffer_index) {
+    return make(file_operation::kind::write, file,
+                const_cast<std::byte *>(buffer.data()), buffer.size(), offset,
+                m_ring ? static_cast<int>(buffer_index) : -1);
+  }
+};
+
+namespace detail {
+
+  inline void file_operation::await_suspend(std::coroutine_handle<> handle) {
+    this->handle = handle;
+    io.enqueue(*this);
+  }
+
+} // namespace detail
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_FILE_IO_HPP
@@ -0,0 +1,179 @@
+#ifndef GKXX_CORO_FRAME_POOL_HPP
+#define GKXX_CORO_FRAME_POOL_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace gkxx {
+
+// Per-thread cache of coroutine frames in power-of-two size classes from 64
+// to 4096 bytes (header included); larger frames go straight to operator
+// new. Every block remembers the pool it came from. Freeing on that pool's
+// thread is a push onto a plain list; freeing on any other thread is a
+// lock-free push onto the owner's remote list, which the owner takes over
+// with a single exchange when its local list runs dry. Blocks are never
+// popped concurrently, so the remote list has no ABA problem.
+//
+// A pool outlives its thread for as long as frames it handed out are
+// alive: at thread exit it stops caching, and the last of those frames to
+// be freed deletes it.
+class FramePool {
+  static constexpr std::size_t class_count = 7;
+  static constexpr std::size_t min_block_shift = 6;
+  static constexpr std::size_t max_cached = 1024;
+
+  struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) header {
+    FramePool *owner;
+    std::size_t size_class;
+  };
+
+  // A free block links to the next one through its first payload word.
+  static header *&next(header *block) noexcept {
+    return *reinterpret_cast<header **>(block + 1);
+  }
+
+  header *m_free[class_count]{};
+  std::size_t m_cached[class_count]{};
+  // Blocks handed out and not yet back on this pool's local lists.
+  std::size_t m_outstanding = 0;
+  alignas(64) std::atomic<header *> m_remote{nullptr};
+  std::atomic<std::size_t> m_orphan_refs{0};
+
+  static inline thread_local FramePool *tl_pool = nullptr;
+  static inline thread_local bool tl_exited = false;
+
+  struct thread_holder {
+    FramePool *pool = new FramePool;
+
+    thread_holder() noexcept {
+      tl_pool = pool;
+    }
+    ~thread_holder() {
+      tl_pool = nullptr;
+      tl_exited = true;
+      pool->orphan();
+    }
+  };
+
+  FramePool() = default;
+  FramePool(const FramePool &) = delete;
+
+  static header *orphaned() noexcept {
+    return reinterpret_cast<header *>(std::uintptr_t{1});
+  }
+
+  static std::size_t class_of(std::size_t block_size) noexcept {
+    return block_size <= (std::size_t{1} << min_block_shift)
+               ? 0
+               : std::bit_width((block_size - 1) >> min_block_shift);
+  }
+  static std::size_t class_size(std::size_t size_class) noexcept {
+    return std::size_t{1} << (size_class + min_block_shift);
+  }
+
+  static FramePool *current() {
+    if (tl_pool || tl_exited)
+      return tl_pool;
+    thread_local thread_holder holder;
+    return holder.pool;
+  }
+
+  void cache(header *block) noexcept {
+    auto c = block->size_class;
+    if (m_cached[c] == max_cached) {
+      ::operator delete(block);
+      return;
+    }
+    next(block) = m_free[c];
+    m_free[c] = block;
+    ++m_cached[c];
+  }
+
+  void collect_remote() noexcept {
+    auto list = m_remote.exchange(nullptr, std::memory_order_acquire);
+    while (list) {
+      auto block = std::exchange(list, next(list));
+      --m_outstanding;
+      cache(block);
+    }
+  }
+
+  void free_remote(header *block) noexcept {
+    auto head = m_remote.load(std::memory_order_acquire);
+    do {
+      if (head == orphaned()) {
+        ::operator delete(block);
+        release_orphan_refs(1);
+        return;
+      }
+      next(block) = head;
+    } while (!m_remote.compare_exchange_weak(head, block,
+                                             std::memory_order_release,
+                                             std::memory_order_acquire));
+  }
+
+  void release_orphan_refs(std::size_t n) noexcept {
+    if (m_orphan_refs.fetch_sub(n, std::memory_order_acq_rel) == n)
+      delete this;
+  }
+
+  // Called when the owning thread exits. Remote frees from then on delete
+  // their block and drop one reference; the thread holds one more.
+  void orphan() noexcept {
+    for (auto &list : m_free)
+      while (list)
+        ::operator delete(std::exchange(list, next(list)));
+    m_orphan_refs.store(m_outstanding + 1, std::memory_order_relaxed);
+    auto list = m_remote.exchange(orphaned(), std::memory_order_acq_rel);
+    std::size_t drained = 0;
+    for (; list; ++drained)
+      ::operator delete(std::exchange(list, next(list)));
+    release_orphan_refs(drained + 1);
+  }
+
+ public:
+  static void *allocate(std::size_t size) {
+    auto block_size = size + sizeof(header);
+    auto c = class_of(block_size);
+    auto pool = c < class_count ? current() : nullptr;
+    header *block;
+    if (!pool) {
+      block = static_cast<header *>(::operator new(block_size));
+      block->owner = nullptr;
+    } else {
+      if (!pool->m_free[c])
+        pool->collect_remote();
+      if ((block = pool->m_free[c])) {
+        pool->m_free[c] = next(block);
+        --pool->m_cached[c];
+      } else {
+        block = static_cast<header *>(::operator new(class_size(c)));
+        block->owner = pool;
+        block->size_class = c;
+      }
+      ++pool->m_outstanding;
+    }
+    return block + 1;
+  }
+
+  static void deallocate(void *p) noexcept {
+    auto block = static_cast<header *>(p) - 1;
+    auto owner = block->owner;
+    if (!owner) {
+      ::operator delete(block);
+    } else if (owner == tl_pool) {
+      --owner->m_outstanding;
+      owner->cache(block);
+    } else {
+      owner->free_remote(block);
+    }
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_FRAME_POOL_HPP
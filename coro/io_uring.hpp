@@ -0,0 +1,178 @@
+#ifndef GKXX_CORO_IO_URING_HPP
+#define GKXX_CORO_IO_URING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace gkxx {
+
+// Minimal io_uring instance on top of the raw system calls: the rings are
+// mapped once, SQEs are filled in shared memory and handed over by
+// submit() in one io_uring_enter, and completions are read back from the
+// CQ ring without any system call.
+class IoUring {
+  int m_fd = -1;
+  void *m_sq_ring = MAP_FAILED;
+  void *m_cq_ring = MAP_FAILED;
+  std::size_t m_sq_ring_size = 0;
+  std::size_t m_cq_ring_size = 0;
+  ::io_uring_sqe *m_sqes = static_cast<::io_uring_sqe *>(MAP_FAILED);
+  std::size_t m_sqes_size = 0;
+
+  unsigned *m_sq_head, *m_sq_tail, *m_sq_array;
+  unsigned m_sq_mask, m_sq_entries;
+  unsigned *m_cq_head, *m_cq_tail;
+  ::io_uring_cqe *m_cqes;
+  unsigned m_cq_mask, m_cq_entries;
+  // Tail of the SQEs handed out by get_sqe() but not yet published.
+  unsigned m_local_tail = 0;
+
+  static unsigned *at(void *base, unsigned offset) noexcept {
+    return reinterpret_cast<unsigned *>(static_cast<char *>(base) + offset);
+  }
+  static unsigned load_acquire(unsigned *p) noexcept {
+    return std::atomic_ref<unsigned>{*p}.load(std::memory_order_acquire);
+  }
+  static void store_release(unsigned *p, unsigned value) noexcept {
+    std::atomic_ref<unsigned>{*p}.store(value, std::memory_order_release);
+  }
+
+  void *map(std::size_t size, off_t offset) {
+    auto ret = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_fd, offset);
+    if (ret == MAP_FAILED)
+      throw std::system_error(errno, std::system_category(), "io_uring mmap");
+    return ret;
+  }
+
+  void release() noexcept {
+    if (m_sqes != MAP_FAILED)
+      ::munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring)
+      ::munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring != MAP_FAILED)
+      ::munmap(m_sq_ring, m_sq_ring_size);
+    if (m_fd >= 0)
+      ::close(m_fd);
+  }
+
+ public:
+  // Throws std::system_error if the kernel does not support io_uring or
+  // does not allow it (ENOSYS, EPERM).
+  explicit IoUring(unsigned entries = 256) {
+    ::io_uring_params params{};
+    m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (m_fd < 0)
+      throw std::system_error(errno, std::system_category(), "io_uring_setup");
+    try {
+      m_sq_ring_size =
+          params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      m_cq_ring_size =
+          params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+      if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        m_sq_ring_size = m_cq_ring_size =
+            std::max(m_sq_ring_size, m_cq_ring_size);
+        m_sq_ring = m_cq_ring = map(m_sq_ring_size, IORING_OFF_SQ_RING);
+      } else {
+        m_sq_ring = map(m_sq_ring_size, IORING_OFF_SQ_RING);
+        m_cq_ring = map(m_cq_ring_size, IORING_OFF_CQ_RING);
+      }
+      m_sqes_size = params.sq_entries * sizeof(::io_uring_sqe);
+      m_sqes = static_cast<::io_uring_sqe *>(map(m_sqes_size, IORING_OFF_SQES));
+    } catch (...) {
+      release();
+      throw;
+    }
+    m_sq_head = at(m_sq_ring, params.sq_off.head);
+    m_sq_tail = at(m_sq_ring, params.sq_off.tail);
+    m_sq_array = at(m_sq_ring, params.sq_off.array);
+    m_sq_mask = *at(m_sq_ring, params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_cq_head = at(m_cq_ring, params.cq_off.head);
+    m_cq_tail = at(m_cq_ring, params.cq_off.tail);
+    m_cqes = reinterpret_cast<::io_uring_cqe *>(
+        static_cast<char *>(m_cq_ring) + params.cq_off.cqes);
+    m_cq_mask = *at(m_cq_ring, params.cq_off.ring_mask);
+    m_cq_entries = params.cq_entries;
+    m_local_tail = *m_sq_tail;
+  }
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  ~IoUring() {
+    release();
+  }
+
+  unsigned sq_entries() const noexcept {
+    return m_sq_entries;
+  }
+  unsigned cq_entries() const noexcept {
+    return m_cq_entries;
+  }
+
+  // A zeroed SQE, or nullptr if the submission queue is full.
+  ::io_uring_sqe *get_sqe() noexcept {
+    if (m_local_tail - load_acquire(m_sq_head) >= m_sq_entries)
+      return nullptr;
+    auto index = m_local_tail & m_sq_mask;
+    auto sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    m_sq_array[index] = index;
+    ++m_local_tail;
+    return sqe;
+  }
+
+  // Publishes every SQE obtained so far and asks the kernel to consume
+  // them. Returns the number consumed; the rest stay queued.
+  unsigned submit() {
+    store_release(m_sq_tail, m_local_tail);
+    auto pending = m_local_tail - load_acquire(m_sq_head);
+    if (pending == 0)
+      return 0;
+    while (true) {
+      auto ret = ::syscall(__NR_io_uring_enter, m_fd, pending, 0, 0, nullptr,
+                           0);
+      if (ret >= 0)
+        return static_cast<unsigned>(ret);
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EBUSY)
+        return 0;
+      throw std::system_error(errno, std::system_category(),
+                              "io_uring_enter");
+    }
+  }
+
+  // Calls `f(cqe)` for every completion that has arrived.
+  template <typename F>
+  unsigned reap(F &&f) {
+    auto head = *m_cq_head;
+    auto tail = load_acquire(m_cq_tail);
+    unsigned count = 0;
+    for (; head != tail; ++head, ++count)
+      f(const_cast<const ::io_uring_cqe &>(m_cqes[head & m_cq_mask]));
+    store_release(m_cq_head, head);
+    return count;
+  }
+
+  void register_resource(unsigned opcode, const void *arg, unsigned count) {
+    if (::syscall(__NR_io_uring_register, m_fd, opcode, arg, count) < 0)
+      throw std::system_error(errno, std::system_category(),
+                              "io_uring_register");
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_IO_URING_HPP
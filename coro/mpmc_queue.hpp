@@ -0,0 +1,179 @@
+#ifndef GKXX_CORO_MPMC_QUEUE_HPP
+#define GKXX_CORO_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace gkxx {
+
+// Bounded multi-producer/multi-consumer queue after Dmitry Vyukov's
+// "Bounded MPMC queue". Every cell carries a sequence number that tells
+// producers and consumers whose turn it is, so a push or pop is one CAS on
+// the shared position plus one store to the cell. Cells and both positions
+// sit on separate cache lines. Nothing is allocated after construction.
+template <typename Type>
+class MpmcQueue {
+  static constexpr std::size_t cache_line = 64;
+
+  struct alignas(cache_line) cell {
+    std::atomic<std::size_t> sequence;
+    alignas(Type) unsigned char storage[sizeof(Type)];
+
+    Type *ptr() noexcept {
+      return std::launder(reinterpret_cast<Type *>(storage));
+    }
+  };
+
+  const std::size_t m_mask;
+  std::unique_ptr<cell[]> m_cells;
+  alignas(cache_line) std::atomic<std::size_t> m_enqueue_pos{0};
+  alignas(cache_line) std::atomic<std::size_t> m_dequeue_pos{0};
+
+  static std::size_t round_up(std::size_t n) noexcept {
+    std::size_t ret = 2;
+    while (ret < n)
+      ret *= 2;
+    return ret;
+  }
+
+ public:
+  explicit MpmcQueue(std::size_t capacity = 1024)
+      : m_mask{round_up(capacity) - 1},
+        m_cells{std::make_unique<cell[]>(m_mask + 1)} {
+    for (std::size_t i = 0; i <= m_mask; ++i)
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpmcQueue(const MpmcQueue &) = delete;
+  MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+  ~MpmcQueue() {
+    while (try_pop())
+      ;
+  }
+
+  std::size_t capacity() const noexcept {
+    return m_mask + 1;
+  }
+
+  template <typename... Args>
+  bool try_emplace(Args &&...args) {
+    auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    cell *c;
+    while (true) {
+      c = &m_cells[pos & m_mask];
+      auto seq = c->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void *>(c->storage)) Type(std::forward<Args>(args)...);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const Type &value) {
+    return try_emplace(value);
+  }
+  bool try_push(Type &&value) {
+    return try_emplace(std::move(value));
+  }
+
+  std::optional<Type> try_pop() {
+    auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    cell *c;
+    while (true) {
+      c = &m_cells[pos & m_mask];
+      auto seq = c->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+      if (diff == 0) {
+        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    std::optional<Type> ret{std::move(*c->ptr())};
+    std::destroy_at(c->ptr());
+    c->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return ret;
+  }
+
+  // Approximate, for heuristics only.
+  bool empty() const noexcept {
+    return m_enqueue_pos.load(std::memory_order_relaxed) ==
+           m_dequeue_pos.load(std::memory_order_relaxed);
+  }
+};
+
+// MpmcQueue with an unbounded, mutex-protected overflow for bursts larger
+// than the ring. The overflow is only touched while it is non-empty, so the
+// common path stays lock-free and allocation-free. Items that went through
+// the overflow may be popped after items pushed later into the ring.
+template <typename Type>
+class InjectionQueue {
+  MpmcQueue<Type> m_ring;
+  alignas(64) std::atomic<std::size_t> m_overflow_size{0};
+  std::mutex m_overflow_mutex;
+  std::deque<Type> m_overflow;
+
+ public:
+  explicit InjectionQueue(std::size_t capacity = 1024) : m_ring{capacity} {}
+
+  void push(Type value) {
+    if (m_overflow_size.load(std::memory_order_relaxed) == 0 &&
+        m_ring.try_push(std::move(value)))
+      return;
+    std::lock_guard lock{m_overflow_mutex};
+    // Move what fits back into the ring first so that the overflow drains.
+    while (!m_overflow.empty() &&
+           m_ring.try_push(std::move(m_overflow.front())))
+      m_overflow.pop_front();
+    if (m_overflow.empty() && m_ring.try_push(std::move(value))) {
+      m_overflow_size.store(0, std::memory_order_release);
+      return;
+    }
+    m_overflow.push_back(std::move(value));
+    m_overflow_size.store(m_overflow.size(), std::memory_order_release);
+  }
+
+  std::optional<Type> try_pop() {
+    if (auto ret = m_ring.try_pop())
+      return ret;
+    if (m_overflow_size.load(std::memory_order_acquire) == 0)
+      return std::nullopt;
+    std::lock_guard lock{m_overflow_mutex};
+    if (m_overflow.empty())
+      return std::nullopt;
+    std::optional<Type> ret{std::move(m_overflow.front())};
+    m_overflow.pop_front();
+    m_overflow_size.store(m_overflow.size(), std::memory_order_release);
+    return ret;
+  }
+
+  bool empty() const noexcept {
+    return m_ring.empty() &&
+           m_overflow_size.load(std::memory_order_relaxed) == 0;
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_MPMC_QUEUE_HPP
@@ -0,0 +1,247 @@
+#ifndef GKXX_CORO_PARALLEL_HPP
+#define GKXX_CORO_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "task.hpp"
+
+namespace gkxx {
+
+namespace detail {
+
+  // Joins the tasks forked by one chunk: the count starts at one for the
+  // chunk itself, which gives it up when it awaits the counter.
+  class fork_join_counter : public task_notifier {
+    std::atomic<std::size_t> m_count{1};
+    std::coroutine_handle<> m_awaiting{};
+
+    static std::coroutine_handle<> on_task_done(task_notifier &n) noexcept {
+      auto &self = static_cast<fork_join_counter &>(n);
+      if (self.m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        return self.m_awaiting;
+      return std::noop_coroutine();
+    }
+
+   public:
+    fork_join_counter() noexcept : task_notifier{&on_task_done} {}
+    fork_join_counter(const fork_join_counter &) = delete;
+
+    template <typename Type>
+    void fork(Task<Type> &task) {
+      m_count.fetch_add(1, std::memory_order_relaxed);
+      task_access::start(task, *this);
+    }
+
+    bool await_ready() const noexcept {
+      return m_count.load(std::memory_order_acquire) == 1;
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      m_awaiting = awaiting;
+      return m_count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+  };
+
+  // Whether the calling worker should hand off part of its range. Only
+  // executors that expose their local queue can tell; the others run every
+  // range inline.
+  template <typename Executor>
+  bool wants_work(const Executor &executor) noexcept {
+    if constexpr (requires { executor.local_queue_size(); })
+      return executor.local_queue_size() == 0;
+    else
+      return false;
+  }
+
+  // Number of elements a chunk runs between two checks for idle workers.
+  // With a fixed grain it stays put; otherwise it is doubled or halved
+  // until a block takes about `target`.
+  class parallel_block {
+    using clock_type = std::chrono::steady_clock;
+    static constexpr std::chrono::microseconds target{20};
+
+    std::size_t m_size;
+    bool m_adaptive;
+    clock_type::time_point m_start{};
+
+   public:
+    explicit parallel_block(std::size_t grain) noexcept
+        : m_size{grain == 0 ? 1 : grain}, m_adaptive{grain == 0} {}
+
+    std::size_t size() const noexcept {
+      return m_size;
+    }
+    void begin() noexcept {
+      if (m_adaptive)
+        m_start = clock_type::now();
+    }
+    void end() {
+      if (!m_adaptive)
+        return;
+      auto elapsed = clock_type::now() - m_start;
+      if (elapsed < target / 2)
+        m_size *= 2;
+      else if (elapsed > target * 2 && m_size > 1)
+        m_size /= 2;
+    }
+  };
+
+  // Block results waiting to be combined, kept like the digits of a binary
+  // counter: two partial results are combined as soon as they cover the
+  // same number of blocks. Combining stays balanced (and in order), so
+  // something like merging sorted runs costs O(n log n) overall.
+  template <typename Value, typename Combine>
+  class partial_results {
+    std::vector<std::pair<Value, std::size_t>> m_stack;
+
+   public:
+    void push(Value value, Combine &combine) {
+      std::size_t blocks = 1;
+      while (!m_stack.empty() && m_stack.back().second == blocks) {
+        value = std::invoke(combine, std::move(m_stack.back().first),
+                            std::move(value));
+        m_stack.pop_back();
+        blocks *= 2;
+      }
+      m_stack.emplace_back(std::move(value), blocks);
+    }
+
+    Value take(const Value &identity, Combine &combine) {
+      if (m_stack.empty())
+        return identity;
+      auto ret = std::move(m_stack.back().first);
+      for (auto i = m_stack.size() - 1; i-- != 0;)
+        ret = std::invoke(combine, std::move(m_stack[i].first),
+                          std::move(ret));
+      m_stack.clear();
+      return ret;
+    }
+  };
+
+  // Kept out of line: inlined into the coroutine, GCC leaves the body's
+  // accumulators in the frame and reloads them on every element, which
+  // makes a simple sum over doubles almost three times slower.
+  template <typename BlockFn, typename Iterator>
+  [[gnu::noinline]] auto run_block(BlockFn &block_fn, Iterator first,
+                                   Iterator last) {
+    return std::invoke(block_fn, std::ranges::subrange(first, last));
+  }
+
+  // Runs [first, last) block by block. Whenever the worker's deque is
+  // empty, i.e. other workers are out of work, the second half of what is
+  // left is forked as a new chunk, which waits in the deque to be stolen
+  // (lazy binary splitting). Uneven ranges therefore split where the work
+  // actually is, and a range nobody steals from costs one task.
+  template <typename Executor, typename Iterator, typename Value,
+            typename BlockFn, typename Combine>
+  Task<Value> parallel_chunk(Executor &executor, Iterator first,
+                             Iterator last, parallel_block block,
+                             const Value &identity, BlockFn &block_fn,
+                             Combine &combine, bool forked) {
+    if (forked) {
+      if constexpr (requires { executor.fork(); })
+        co_await executor.fork();
+      else
+        co_await executor.suspend();
+    }
+    fork_join_counter join;
+    std::vector<Task<Value>> children;
+    partial_results<Value, Combine> results;
+    std::exception_ptr exception;
+    try {
+      while (first != last) {
+        auto left = static_cast<std::size_t>(last - first);
+        if (left >= 2 * block.size() && wants_work(executor)) {
+          auto mid = first + static_cast<std::iter_difference_t<Iterator>>(
+                                 left / 2);
+          children.push_back(parallel_chunk(executor, mid, last, block,
+                                            identity, block_fn, combine,
+                                            true));
+          join.fork(children.back());
+          last = mid;
+          continue;
+        }
+        auto end = first + static_cast<std::iter_difference_t<Iterator>>(
+                               std::min(left, block.size()));
+        block.begin();
+        results.push(run_block(block_fn, first, end), combine);
+        block.end();
+        first = end;
+      }
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    co_await join;
+    if (exception)
+      std::rethrow_exception(exception);
+    // The children were forked from the back of the range, so the first
+    // one covers the last part.
+    auto ret = results.take(identity, combine);
+    for (auto it = children.rbegin(); it != children.rend(); ++it)
+      ret = std::invoke(combine, std::move(ret), task_access::result(*it));
+    co_return ret;
+  }
+
+  template <typename Executor, typename View, typename Value,
+            typename BlockFn, typename Combine>
+  Task<Value> parallel_root(Executor &executor, View view, std::size_t grain,
+                            Value identity, BlockFn block_fn,
+                            Combine combine) {
+    co_return co_await parallel_chunk(
+        executor, std::ranges::begin(view), std::ranges::end(view),
+        parallel_block{grain}, identity, block_fn, combine, false);
+  }
+
+} // namespace detail
+
+// Reduces `range` in parallel on `executor`: `block_fn` maps a contiguous
+// subrange to a Value and `combine` merges two adjacent results (left one
+// first), so it has to be associative but not commutative. The range is
+// split recursively into tasks while other workers are idle. A `grain` of
+// 0 picks the block length automatically; otherwise it is the number of
+// elements per block_fn call. The range, or what it refers to, must stay
+// alive until the task finishes.
+template <typename Executor, std::ranges::random_access_range Range,
+          typename Value, typename BlockFn, typename Combine>
+  requires std::ranges::viewable_range<Range> &&
+           std::ranges::common_range<Range>
+Task<Value> parallel_reduce(Executor &executor, Range &&range,
+                            std::size_t grain, Value identity,
+                            BlockFn block_fn, Combine combine) {
+  return detail::parallel_root(
+      executor, std::views::all(std::forward<Range>(range)), grain,
+      std::move(identity), std::move(block_fn), std::move(combine));
+}
+
+// Calls `body(x)` for every element of `range`, in parallel on `executor`.
+// See parallel_reduce() for `grain`.
+template <typename Executor, std::ranges::random_access_range Range,
+          typename Body>
+  requires std::ranges::viewable_range<Range> &&
+           std::ranges::common_range<Range>
+Task<> parallel_for(Executor &executor, Range &&range, std::size_t grain,
+                    Body body) {
+  co_await parallel_reduce(
+      executor, std::forward<Range>(range), grain, std::monostate{},
+      [body = std::move(body)](auto block) mutable {
+        for (auto &&x : block)
+          std::invoke(body, std::forward<decltype(x)>(x));
+        return std::monostate{};
+      },
+      [](std::monostate, std::monostate) { return std::monostate{}; });
+}
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_PARALLEL_HPP
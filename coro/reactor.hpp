@@ -0,0 +1,188 @@
+#ifndef GKXX_CORO_REACTOR_HPP
+#define GKXX_CORO_REACTOR_HPP
+
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace gkxx {
+
+// A pending non-blocking operation. `perform` retries the system call and
+// returns false if it would still block; the operation lives in the awaiter
+// of the suspended coroutine, so waiting for I/O allocates nothing.
+struct IoOperation {
+  bool (*perform)(IoOperation &) noexcept;
+  std::coroutine_handle<> handle{};
+};
+
+// Something that queues operations and hands them to the kernel in
+// batches. `flush` runs at the start of every Reactor::poll(); it returns
+// true if it has already made some task ready, in which case poll() does
+// not block.
+struct IoBatcher {
+  bool (*flush)(IoBatcher &);
+  IoBatcher *next = nullptr;
+};
+
+// Edge-triggered epoll loop. Every fd is registered once for both
+// directions; an operation that hits EAGAIN parks itself in the fd's slot
+// and is retried by poll() on the next edge.
+class Reactor {
+ public:
+  enum class direction { read, write };
+
+ private:
+  struct fd_state {
+    IoOperation *reader = nullptr;
+    IoOperation *writer = nullptr;
+  };
+
+  int m_epoll_fd;
+  int m_wake_fd;
+  std::vector<fd_state> m_fds;
+  std::size_t m_waiting = 0;
+  IoBatcher *m_batchers = nullptr;
+
+  IoOperation *&slot(int fd, direction dir) {
+    auto index = static_cast<std::size_t>(fd);
+    if (index >= m_fds.size())
+      m_fds.resize(index + 1);
+    auto &state = m_fds[index];
+    return dir == direction::read ? state.reader : state.writer;
+  }
+
+  template <typename Ready>
+  void complete(IoOperation *&op, Ready &ready) {
+    if (op && op->perform(*op)) {
+      --m_waiting;
+      ready(std::exchange(op, nullptr)->handle);
+    }
+  }
+
+ public:
+  Reactor() {
+    m_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0)
+      throw std::system_error(errno, std::system_category(), "epoll_create1");
+    m_wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wake_fd < 0) {
+      auto error = errno;
+      ::close(m_epoll_fd);
+      throw std::system_error(error, std::system_category(), "eventfd");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wake_fd;
+    ::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &event);
+  }
+
+  Reactor(const Reactor &) = delete;
+  Reactor &operator=(const Reactor &) = delete;
+
+  ~Reactor() {
+    ::close(m_wake_fd);
+    ::close(m_epoll_fd);
+  }
+
+  void add(int fd) {
+    slot(fd, direction::read) = nullptr;
+    slot(fd, direction::write) = nullptr;
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    if (::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+      throw std::system_error(errno, std::system_category(), "epoll_ctl");
+  }
+
+  // Must be called before `fd` is closed. Operations still waiting on it
+  // are forgotten, not resumed.
+  void remove(int fd) noexcept {
+    ::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    auto index = static_cast<std::size_t>(fd);
+    if (fd < 0 || index >= m_fds.size())
+      return;
+    auto &state = m_fds[index];
+    m_waiting -= (state.reader != nullptr) + (state.writer != nullptr);
+    state = {};
+  }
+
+  // At most one reader and one writer may wait on an fd at a time.
+  void wait(int fd, direction dir, IoOperation &op) {
+    slot(fd, dir) = &op;
+    ++m_waiting;
+  }
+  void cancel(int fd, direction dir, IoOperation &op) noexcept {
+    auto index = static_cast<std::size_t>(fd);
+    if (fd < 0 || index >= m_fds.size())
+      return;
+    auto &state = m_fds[index];
+    auto &current = dir == direction::read ? state.reader : state.writer;
+    if (current == &op) {
+      current = nullptr;
+      --m_waiting;
+    }
+  }
+
+  void add_batcher(IoBatcher &batcher) noexcept {
+    batcher.next = std::exchange(m_batchers, &batcher);
+  }
+  void remove_batcher(IoBatcher &batcher) noexcept {
+    for (auto p = &m_batchers; *p; p = &(*p)->next)
+      if (*p == &batcher) {
+        *p = batcher.next;
+        return;
+      }
+  }
+
+  bool has_waiters() const noexcept {
+    return m_waiting != 0;
+  }
+
+  // Waits up to `timeout_ms` (-1: forever) for readiness and passes the
+  // handle of every operation that has completed to `ready`.
+  template <typename Ready>
+  void poll(int timeout_ms, Ready &&ready) {
+    for (auto batcher = m_batchers; batcher; batcher = batcher->next)
+      if (batcher->flush(*batcher))
+        timeout_ms = 0;
+    epoll_event events[64];
+    auto n = ::epoll_wait(m_epoll_fd, events, 64, timeout_ms);
+    if (n < 0) {
+      if (errno == EINTR)
+        return;
+      throw std::system_error(errno, std::system_category(), "epoll_wait");
+    }
+    for (int i = 0; i != n; ++i) {
+      auto fd = events[i].data.fd;
+      auto mask = events[i].events;
+      if (fd == m_wake_fd) {
+        std::uint64_t count;
+        [[maybe_unused]] auto r = ::read(m_wake_fd, &count, sizeof(count));
+        continue;
+      }
+      auto &state = m_fds[static_cast<std::size_t>(fd)];
+      if (mask & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        complete(state.reader, ready);
+      if (mask & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+        complete(state.writer, ready);
+    }
+  }
+
+  // Interrupts a poll() blocked in another thread. Thread-safe.
+  void wake() noexcept {
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto r = ::write(m_wake_fd, &one, sizeof(one));
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_REACTOR_HPP
@@ -0,0 +1,321 @@
+#ifndef GKXX_CORO_SCHEDULER_HPP
+#define GKXX_CORO_SCHEDULER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <utility>
+
+#include "dary_heap.hpp"
+#include "mpmc_queue.hpp"
+#include "reactor.hpp"
+#include "scheduler_metrics.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+
+namespace gkxx {
+
+// Scheduling class of a task queued through Scheduler::post(handle,
+// priority) or suspend(priority). Ready tasks of a higher class always run
+// first, so background work cannot delay interactive tasks by more than
+// the one resume already in progress.
+enum class Priority : std::uint8_t { interactive, normal, background };
+
+struct Scheduler {
+  static constexpr auto no_deadline = TimerWheel::time_point::max();
+
+  // Normal tasks without a deadline: everything queued without a priority,
+  // including tasks woken by timers, sockets, submit() and the primitives
+  // in channel.hpp and sync.hpp.
+  std::queue<std::coroutine_handle<>> m_tasks{};
+  // Everything else, one heap per class ordered by deadline (earliest
+  // first), then by arrival.
+  struct prioritized_task {
+    TimerWheel::time_point deadline;
+    std::uint64_t seq;
+    std::coroutine_handle<> handle;
+
+    friend bool operator<(const prioritized_task &lhs,
+                          const prioritized_task &rhs) noexcept {
+      return lhs.deadline != rhs.deadline ? lhs.deadline < rhs.deadline
+                                          : lhs.seq < rhs.seq;
+    }
+  };
+  std::array<DaryHeap<prioritized_task>, 3> m_prioritized{};
+  std::size_t m_prioritized_count = 0;
+  std::uint64_t m_next_seq = 0;
+  // Tasks handed over by other threads through submit().
+  InjectionQueue<std::coroutine_handle<>> m_injected{256};
+  // Tasks sleeping in sleep_for() or sleep_until().
+  TimerWheel m_timers{};
+  std::size_t m_resumes_since_poll = 0;
+  // Tasks waiting for socket readiness (see socket.hpp). The scheduler also
+  // parks in it, so submit() can wake it through the reactor's eventfd.
+  Reactor m_reactor{};
+  std::atomic<bool> m_parked{false};
+  // Budget of the running task, see maybe_yield(). The counters are reset
+  // on every resume. The first maybe_yield() of a resume starts the slice;
+  // after that the clock is only read every `budget_check_interval` calls,
+  // so tasks that never call maybe_yield() never read it.
+  static constexpr std::uint64_t budget_check_interval = 64;
+  std::uint64_t m_yield_calls = ~std::uint64_t{0};
+  std::chrono::microseconds m_yield_time{500};
+  std::uint64_t m_yield_ticks = 0;
+  std::uint64_t m_budget_countdown = budget_check_interval;
+  std::uint64_t m_budget_step = budget_check_interval;
+  std::uint64_t m_budget_calls = 0;
+  std::uint64_t m_slice_start = 0;
+
+  void post(std::coroutine_handle<> handle) {
+    m_tasks.push(handle);
+  }
+  void post(std::coroutine_handle<> handle, Priority priority,
+            TimerWheel::time_point deadline = no_deadline) {
+    if (priority == Priority::normal && deadline == no_deadline) {
+      m_tasks.push(handle);
+      return;
+    }
+    m_prioritized[static_cast<std::size_t>(priority)].push(
+        {deadline, m_next_seq++, handle});
+    ++m_prioritized_count;
+  }
+
+  // Thread-safe counterpart of post() for code running outside the thread
+  // that calls schedule().
+  void submit(std::coroutine_handle<> handle) {
+    m_injected.push(handle);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_relaxed))
+      m_reactor.wake();
+  }
+
+  // Queues a task to be started by schedule(). Its frame is destroyed when
+  // it finishes.
+  void spawn(Task<> task) {
+    post(std::move(task).release());
+  }
+  void spawn(Task<> task, Priority priority,
+             TimerWheel::time_point deadline = no_deadline) {
+    post(std::move(task).release(), priority, deadline);
+  }
+
+  bool ready_empty() const noexcept {
+    return m_tasks.empty() && m_prioritized_count == 0;
+  }
+  std::size_t ready_count() const noexcept {
+    return m_tasks.size() + m_prioritized_count;
+  }
+
+  // Interactive, then normal with a deadline, then normal without one,
+  // then background.
+  std::coroutine_handle<> pop_ready() {
+    if (m_prioritized_count != 0) {
+      auto pop = [this](DaryHeap<prioritized_task> &heap) {
+        --m_prioritized_count;
+        return heap.pop().handle;
+      };
+      if (!m_prioritized[0].empty())
+        return pop(m_prioritized[0]);
+      if (!m_prioritized[1].empty())
+        return pop(m_prioritized[1]);
+      if (m_tasks.empty())
+        return pop(m_prioritized[2]);
+    }
+    auto ret = m_tasks.front();
+    m_tasks.pop();
+    return ret;
+  }
+
+  // A task resumed by schedule() may pass `calls` maybe_yield() points or
+  // run for `time` before maybe_yield() suspends it.
+  void set_yield_budget(std::uint64_t calls, std::chrono::microseconds time) {
+    m_yield_calls = calls == 0 ? 1 : calls;
+    m_yield_time = time;
+    m_yield_ticks = 0;
+  }
+
+  void reset_budget() noexcept {
+    m_budget_calls = 0;
+    m_slice_start = 0;
+    m_budget_countdown = m_budget_step = 1;
+  }
+  bool out_of_budget() {
+    if (--m_budget_countdown != 0)
+      return false;
+    return check_budget();
+  }
+  // Time is counted from the first call, so a slice may overrun by up to
+  // `budget_check_interval` calls.
+  bool check_budget() {
+    m_budget_calls += m_budget_step;
+    auto now = CycleClock::now();
+    if (m_slice_start == 0)
+      m_slice_start = now;
+    if (m_yield_ticks == 0)
+      m_yield_ticks = std::max<std::uint64_t>(
+          1, static_cast<std::uint64_t>(
+                 std::chrono::duration<double, std::nano>(m_yield_time)
+                     .count() /
+                 CycleClock::ns_per_tick()));
+    if (m_budget_calls >= m_yield_calls ||
+        now - m_slice_start >= m_yield_ticks) {
+      // Until the next resume, every call suspends.
+      m_budget_countdown = 1;
+      m_budget_step = 0;
+      return true;
+    }
+    m_budget_countdown = m_budget_step =
+        std::min(budget_check_interval, m_yield_calls - m_budget_calls);
+    return false;
+  }
+
+  void poll_timers() {
+    m_timers.advance(TimerWheel::clock_type::now(), [this](TimerNode &node) {
+      m_tasks.push(node.handle);
+    });
+  }
+  void poll_io(int timeout_ms) {
+    m_reactor.poll(timeout_ms, [this](std::coroutine_handle<> handle) {
+      m_tasks.push(handle);
+    });
+  }
+
+  // Blocks until an fd becomes ready, the next timer is due or another
+  // thread calls submit().
+  void park() {
+    int timeout_ms = -1;
+    if (auto deadline = m_timers.next_deadline()) {
+      auto left = *deadline - TimerWheel::clock_type::now();
+      timeout_ms = left <= left.zero()
+                       ? 0
+                       : static_cast<int>(
+                             std::chrono::ceil<std::chrono::milliseconds>(left)
+                                 .count());
+    }
+    m_parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    [[maybe_unused]] detail::metrics_idle_scope idle;
+    poll_io(m_injected.empty() ? timeout_ms : 0);
+    m_parked.store(false, std::memory_order_relaxed);
+  }
+
+  // Resumes one ready task. Timers and sockets are polled whenever nothing
+  // else is ready and every 64 resumes otherwise; with only sleeping or
+  // blocked tasks left, the calling thread parks. Returns false once there
+  // is nothing left to run or wait for.
+  bool schedule() {
+    while (auto handle = m_injected.try_pop())
+      m_tasks.push(*handle);
+    if (ready_empty()) {
+      m_resumes_since_poll = 0;
+      poll_timers();
+      if (ready_empty()) {
+        if (m_timers.empty() && !m_reactor.has_waiters())
+          return false;
+        park();
+        poll_timers();
+        return true;
+      }
+    } else if (m_resumes_since_poll >= 64) {
+      m_resumes_since_poll = 0;
+      poll_timers();
+      if (m_reactor.has_waiters())
+        poll_io(0);
+    }
+    auto task = pop_ready();
+    ++m_resumes_since_poll;
+    if (!task.done()) {
+      [[maybe_unused]] detail::metrics_resume_scope timing{
+          [this] { return ready_count(); }};
+      reset_budget();
+      task.resume();
+    }
+    return !ready_empty() || !m_injected.empty() || !m_timers.empty() ||
+           m_reactor.has_waiters();
+  }
+  auto suspend() {
+    struct awaiter : std::suspend_always {
+      Scheduler &scheduler;
+      constexpr awaiter(Scheduler &s) noexcept : scheduler{s} {}
+      void await_suspend(std::coroutine_handle<> handle) {
+        scheduler.m_tasks.push(handle);
+      }
+    };
+    return awaiter{*this};
+  }
+  // Requeues the awaiting task in the given class; among the tasks of that
+  // class, the earliest deadline runs first.
+  auto suspend(Priority priority,
+               TimerWheel::time_point deadline = no_deadline) {
+    struct awaiter : std::suspend_always {
+      Scheduler &scheduler;
+      Priority priority;
+      TimerWheel::time_point deadline;
+      constexpr awaiter(Scheduler &s, Priority p,
+                        TimerWheel::time_point d) noexcept
+          : scheduler{s}, priority{p}, deadline{d} {}
+      void await_suspend(std::coroutine_handle<> handle) {
+        scheduler.post(handle, priority, deadline);
+      }
+    };
+    return awaiter{*this, priority, deadline};
+  }
+
+  // Yield point for long-running tasks, cheap enough for inner loops: it
+  // suspends like suspend(priority) only once the running task has used up
+  // the budget set by set_yield_budget(), and otherwise does not suspend.
+  auto maybe_yield(Priority priority = Priority::normal) {
+    struct awaiter : std::suspend_always {
+      Scheduler &scheduler;
+      Priority priority;
+      constexpr awaiter(Scheduler &s, Priority p) noexcept
+          : scheduler{s}, priority{p} {}
+      bool await_ready() {
+        return !scheduler.out_of_budget();
+      }
+      void await_suspend(std::coroutine_handle<> handle) {
+        scheduler.post(handle, priority);
+      }
+    };
+    return awaiter{*this, priority};
+  }
+
+  // The timer node lives in the awaiter, i.e. in the sleeping coroutine's
+  // frame. Destroying the frame while it sleeps cancels the timer.
+  auto sleep_until(TimerWheel::time_point deadline) {
+    struct awaiter {
+      Scheduler &scheduler;
+      TimerWheel::time_point deadline;
+      TimerNode node{};
+
+      awaiter(Scheduler &s, TimerWheel::time_point d) noexcept
+          : scheduler{s}, deadline{d} {}
+      awaiter(const awaiter &) = delete;
+      ~awaiter() {
+        scheduler.m_timers.cancel(node);
+      }
+
+      bool await_ready() const noexcept {
+        return deadline <= TimerWheel::clock_type::now();
+      }
+      void await_suspend(std::coroutine_handle<> handle) noexcept {
+        node.handle = handle;
+        scheduler.m_timers.insert(node, deadline);
+      }
+      void await_resume() const noexcept {}
+    };
+    return awaiter{*this, deadline};
+  }
+  auto sleep_for(TimerWheel::duration duration) {
+    return sleep_until(TimerWheel::clock_type::now() + duration);
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_SCHEDULER_HPP
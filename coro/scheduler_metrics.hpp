@@ -0,0 +1,353 @@
+#ifndef GKXX_CORO_SCHEDULER_METRICS_HPP
+#define GKXX_CORO_SCHEDULER_METRICS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace gkxx {
+
+// Cheapest monotonic tick available: the time-stamp counter on x86 (which
+// is invariant on anything recent), steady_clock nanoseconds elsewhere.
+class CycleClock {
+ public:
+  static std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+ private:
+  struct anchor {
+    std::uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+  };
+  static inline const anchor s_anchor{now(),
+                                      std::chrono::steady_clock::now()};
+
+ public:
+  // Measured against steady_clock from program start to first use (at
+  // least 10ms, waiting out the rest if need be), so callers rarely pay for
+  // the calibration.
+  static double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ret = [] {
+      using clock = std::chrono::steady_clock;
+      while (clock::now() - s_anchor.time < std::chrono::milliseconds{10})
+        ;
+      auto c1 = now();
+      auto ns = std::chrono::duration<double, std::nano>(clock::now() -
+                                                         s_anchor.time);
+      return ns.count() / static_cast<double>(c1 - s_anchor.ticks);
+    }();
+    return ret;
+#else
+    return 1e9 * std::chrono::steady_clock::period::num /
+           std::chrono::steady_clock::period::den;
+#endif
+  }
+
+  // What two back-to-back now() calls measure; taken off every timing.
+  static std::uint64_t overhead() {
+    static const std::uint64_t ret = [] {
+      auto best = ~std::uint64_t{0};
+      for (int i = 0; i != 1000; ++i) {
+        auto t0 = now();
+        best = std::min(best, now() - t0);
+      }
+      return best;
+    }();
+    return ret;
+  }
+};
+
+// Totals over every thread that ran a scheduler, or the difference between
+// two of them.
+struct SchedulerMetricsSnapshot {
+  std::uint64_t resumes = 0;
+  std::chrono::nanoseconds busy{0};
+  std::chrono::nanoseconds idle{0};
+  // Run-queue depth seen at each resume.
+  std::uint64_t queue_depth_sum = 0;
+  std::uint64_t queue_depth_max = 0;
+  std::uint64_t steal_attempts = 0;
+  std::uint64_t steals = 0;
+
+  double mean_resume_ns() const noexcept {
+    return resumes == 0 ? 0
+                        : static_cast<double>(busy.count()) /
+                              static_cast<double>(resumes);
+  }
+  double mean_queue_depth() const noexcept {
+    return resumes == 0 ? 0
+                        : static_cast<double>(queue_depth_sum) /
+                              static_cast<double>(resumes);
+  }
+
+  // The maximum depth is not a running total; the difference keeps the
+  // later one.
+  SchedulerMetricsSnapshot
+  operator-(const SchedulerMetricsSnapshot &earlier) const noexcept {
+    return {resumes - earlier.resumes,
+            busy - earlier.busy,
+            idle - earlier.idle,
+            queue_depth_sum - earlier.queue_depth_sum,
+            queue_depth_max,
+            steal_attempts - earlier.steal_attempts,
+            steals - earlier.steals};
+  }
+
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const SchedulerMetricsSnapshot &s) {
+    using ms = std::chrono::duration<double, std::milli>;
+    return os << "resumes " << s.resumes << ", " << s.mean_resume_ns()
+              << " ns/resume, busy " << ms(s.busy).count() << " ms, idle "
+              << ms(s.idle).count() << " ms, queue depth "
+              << s.mean_queue_depth() << " (max " << s.queue_depth_max
+              << "), steals " << s.steals << "/" << s.steal_attempts;
+  }
+};
+
+// Scheduler instrumentation, compiled in only when GKXX_SCHEDULER_METRICS
+// is defined (for the whole program, as it changes the schedulers' inline
+// code). Each thread counts into its own block, which only it writes, so
+// recording a resume is a few plain adds; snapshot() sums the blocks under
+// a lock. Reading the cycle counter costs more than that (it can take over
+// 15ns under virtualization), so only one resume in `sample_period` is
+// timed and the busy time is extrapolated from those. Without the macro
+// the recording hooks are empty and snapshot() returns zeros.
+class SchedulerMetrics {
+ public:
+#ifdef GKXX_SCHEDULER_METRICS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+  static constexpr std::uint64_t sample_period = 16;
+
+ private:
+  struct counters {
+    std::atomic<std::uint64_t> resumes{0};
+    std::atomic<std::uint64_t> busy_ticks{0};
+    std::atomic<std::uint64_t> idle_ticks{0};
+    std::atomic<std::uint64_t> queue_depth_sum{0};
+    std::atomic<std::uint64_t> queue_depth_max{0};
+    std::atomic<std::uint64_t> steal_attempts{0};
+    std::atomic<std::uint64_t> steals{0};
+
+    counters *prev = nullptr;
+    counters *next = nullptr;
+    std::uint64_t clock_overhead = 0;
+
+    // Single writer: no read-modify-write needed.
+    static void add(std::atomic<std::uint64_t> &c,
+                    std::uint64_t n) noexcept {
+      c.store(c.load(std::memory_order_relaxed) + n,
+              std::memory_order_relaxed);
+    }
+
+    void add_to(SchedulerMetricsSnapshot &s, double ns_per_tick) const {
+      auto ns = [ns_per_tick](std::uint64_t ticks) {
+        return std::chrono::nanoseconds{static_cast<std::int64_t>(
+            static_cast<double>(ticks) * ns_per_tick)};
+      };
+      s.resumes += resumes.load(std::memory_order_relaxed);
+      s.busy += ns(busy_ticks.load(std::memory_order_relaxed));
+      s.idle += ns(idle_ticks.load(std::memory_order_relaxed));
+      s.queue_depth_sum += queue_depth_sum.load(std::memory_order_relaxed);
+      s.queue_depth_max = std::max(
+          s.queue_depth_max, queue_depth_max.load(std::memory_order_relaxed));
+      s.steal_attempts += steal_attempts.load(std::memory_order_relaxed);
+      s.steals += steals.load(std::memory_order_relaxed);
+    }
+  };
+
+  // Live threads' blocks, plus one block for the threads that are gone.
+  struct registry {
+    std::mutex mutex;
+    counters *live = nullptr;
+    counters retired;
+  };
+
+  static registry &the_registry() {
+    static registry ret;
+    return ret;
+  }
+
+  static inline thread_local counters *tl_counters = nullptr;
+
+  struct thread_block {
+    counters block;
+
+    thread_block() {
+      block.clock_overhead = CycleClock::overhead();
+      tl_counters = &block;
+      auto &r = the_registry();
+      std::lock_guard lock{r.mutex};
+      block.next = r.live;
+      if (r.live)
+        r.live->prev = &block;
+      r.live = &block;
+    }
+    ~thread_block() {
+      tl_counters = nullptr;
+      auto &r = the_registry();
+      std::lock_guard lock{r.mutex};
+      (block.prev ? block.prev->next : r.live) = block.next;
+      if (block.next)
+        block.next->prev = block.prev;
+      auto &to = r.retired;
+      counters::add(to.resumes, block.resumes.load());
+      counters::add(to.busy_ticks, block.busy_ticks.load());
+      counters::add(to.idle_ticks, block.idle_ticks.load());
+      counters::add(to.queue_depth_sum, block.queue_depth_sum.load());
+      to.queue_depth_max.store(
+          std::max(to.queue_depth_max.load(), block.queue_depth_max.load()));
+      counters::add(to.steal_attempts, block.steal_attempts.load());
+      counters::add(to.steals, block.steals.load());
+    }
+  };
+
+  static counters &local() {
+    if (auto c = tl_counters)
+      return *c;
+    thread_local thread_block ret;
+    return ret.block;
+  }
+
+ public:
+  // Counts a resume; returns whether to time it and report the time to
+  // end_resume().
+  static bool begin_resume(std::uint64_t queue_depth) {
+    auto &c = local();
+    auto n = c.resumes.load(std::memory_order_relaxed);
+    c.resumes.store(n + 1, std::memory_order_relaxed);
+    counters::add(c.queue_depth_sum, queue_depth);
+    if (queue_depth > c.queue_depth_max.load(std::memory_order_relaxed))
+      c.queue_depth_max.store(queue_depth, std::memory_order_relaxed);
+    return n % sample_period == 0;
+  }
+  static void end_resume(std::uint64_t ticks) {
+    auto &c = local();
+    ticks = ticks > c.clock_overhead ? ticks - c.clock_overhead : 0;
+    counters::add(c.busy_ticks, ticks * sample_period);
+  }
+  static void record_idle(std::uint64_t ticks) {
+    counters::add(local().idle_ticks, ticks);
+  }
+  static void record_steal(std::uint64_t attempts, bool stolen) {
+    auto &c = local();
+    counters::add(c.steal_attempts, attempts);
+    counters::add(c.steals, stolen);
+  }
+
+  static SchedulerMetricsSnapshot snapshot() {
+    SchedulerMetricsSnapshot ret;
+    if constexpr (enabled) {
+      auto ns_per_tick = CycleClock::ns_per_tick();
+      auto &r = the_registry();
+      std::lock_guard lock{r.mutex};
+      r.retired.add_to(ret, ns_per_tick);
+      for (auto c = r.live; c; c = c->next)
+        c->add_to(ret, ns_per_tick);
+    }
+    return ret;
+  }
+};
+
+namespace detail {
+
+  // Hooks placed in the schedulers. The queue depth is passed as a
+  // callable so that, with metrics off, not even the loads it takes are
+  // left behind.
+#ifdef GKXX_SCHEDULER_METRICS
+  class metrics_resume_scope {
+    std::uint64_t m_start = 0;
+
+   public:
+    template <typename QueueDepth>
+    explicit metrics_resume_scope(QueueDepth queue_depth) {
+      if (SchedulerMetrics::begin_resume(
+              static_cast<std::uint64_t>(queue_depth())))
+        m_start = CycleClock::now();
+    }
+    metrics_resume_scope(const metrics_resume_scope &) = delete;
+    ~metrics_resume_scope() {
+      if (m_start != 0)
+        SchedulerMetrics::end_resume(CycleClock::now() - m_start);
+    }
+  };
+
+  class metrics_idle_scope {
+    std::uint64_t m_start = CycleClock::now();
+
+   public:
+    metrics_idle_scope() = default;
+    metrics_idle_scope(const metrics_idle_scope &) = delete;
+    ~metrics_idle_scope() {
+      SchedulerMetrics::record_idle(CycleClock::now() - m_start);
+    }
+  };
+
+  inline void metrics_steal(std::uint64_t attempts, bool stolen) {
+    SchedulerMetrics::record_steal(attempts, stolen);
+  }
+#else
+  struct metrics_resume_scope {
+    template <typename QueueDepth>
+    explicit metrics_resume_scope(QueueDepth) noexcept {}
+  };
+  struct metrics_idle_scope {};
+  inline void metrics_steal(std::uint64_t, bool) noexcept {}
+#endif
+
+} // namespace detail
+
+// Writes the metrics gathered over each `interval` to `os` from a thread
+// of its own, until destroyed.
+class SchedulerMetricsDumper {
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop = false;
+  std::thread m_thread;
+
+ public:
+  SchedulerMetricsDumper(std::chrono::milliseconds interval, std::ostream &os)
+      : m_thread{[this, interval, &os,
+                  last = SchedulerMetrics::snapshot()]() mutable {
+          std::unique_lock lock{m_mutex};
+          while (!m_cv.wait_for(lock, interval, [this] { return m_stop; })) {
+            auto now = SchedulerMetrics::snapshot();
+            os << (now - last) << '\n';
+            last = now;
+          }
+        }} {}
+
+  SchedulerMetricsDumper(const SchedulerMetricsDumper &) = delete;
+  SchedulerMetricsDumper &operator=(const SchedulerMetricsDumper &) = delete;
+
+  ~SchedulerMetricsDumper() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_SCHEDULER_METRICS_HPP
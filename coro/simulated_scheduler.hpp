@@ -0,0 +1,175 @@
+#ifndef GKXX_CORO_SIMULATED_SCHEDULER_HPP
+#define GKXX_CORO_SIMULATED_SCHEDULER_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "task.hpp"
+
+namespace gkxx {
+
+// Single-threaded executor with the surface of Scheduler (post(), spawn(),
+// schedule(), suspend(), sleep_for(), sleep_until()) that runs on virtual
+// time, for reproducible tests and load simulations. Resuming a task takes
+// no virtual time; once nothing is ready, the clock jumps straight to the
+// next timer, so hours of timeouts and retries take as long as the code
+// between them. Ready tasks are picked at random from a seeded generator:
+// the same seed gives the same interleaving on every run and platform, and
+// different seeds explore different ones.
+class SimulatedScheduler {
+ public:
+  struct clock_type {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<clock_type>;
+    static constexpr bool is_steady = true;
+  };
+  using time_point = clock_type::time_point;
+  using duration = clock_type::duration;
+
+ private:
+  struct sleep_awaiter;
+  std::vector<std::coroutine_handle<>> m_ready;
+  // Ties are broken by arrival, so equal deadlines fire in a fixed order.
+  using timer_map =
+      std::map<std::pair<time_point, std::uint64_t>, sleep_awaiter *>;
+  timer_map m_timers;
+  std::uint64_t m_next_timer = 0;
+  time_point m_now{};
+  // mt19937_64's output is fixed by the standard (unlike the
+  // distributions), which keeps runs identical across standard libraries.
+  std::mt19937_64 m_random;
+
+  std::coroutine_handle<> pop_ready() {
+    auto i = static_cast<std::size_t>(m_random() % m_ready.size());
+    auto ret = m_ready[i];
+    m_ready[i] = m_ready.back();
+    m_ready.pop_back();
+    return ret;
+  }
+
+  // Jumps to the earliest deadline and readies every timer due then.
+  void advance() {
+    m_now = m_timers.begin()->first.first;
+    while (!m_timers.empty() && m_timers.begin()->first.first <= m_now) {
+      auto sleeper = m_timers.begin()->second;
+      sleeper->armed = false;
+      m_ready.push_back(sleeper->handle);
+      m_timers.erase(m_timers.begin());
+    }
+  }
+
+  // Lives in the sleeping coroutine's frame; destroying the frame while it
+  // sleeps cancels the timer.
+  struct sleep_awaiter {
+    SimulatedScheduler &scheduler;
+    time_point deadline;
+    std::coroutine_handle<> handle{};
+    timer_map::iterator timer{};
+    bool armed = false;
+
+    sleep_awaiter(SimulatedScheduler &s, time_point d) noexcept
+        : scheduler{s}, deadline{d} {}
+    sleep_awaiter(const sleep_awaiter &) = delete;
+    ~sleep_awaiter() {
+      if (armed)
+        scheduler.m_timers.erase(timer);
+    }
+
+    bool await_ready() const noexcept {
+      return deadline <= scheduler.m_now;
+    }
+    void await_suspend(std::coroutine_handle<> awaiting) {
+      handle = awaiting;
+      timer = scheduler.m_timers
+                  .emplace(std::pair{deadline, scheduler.m_next_timer++}, this)
+                  .first;
+      armed = true;
+    }
+    void await_resume() const noexcept {}
+  };
+
+ public:
+  explicit SimulatedScheduler(std::uint64_t seed = 0) : m_random{seed} {}
+
+  SimulatedScheduler(const SimulatedScheduler &) = delete;
+  SimulatedScheduler &operator=(const SimulatedScheduler &) = delete;
+
+  time_point now() const noexcept {
+    return m_now;
+  }
+  // A source of randomness for the simulated code that follows the seed.
+  std::uint64_t random() {
+    return m_random();
+  }
+
+  void post(std::coroutine_handle<> handle) {
+    m_ready.push_back(handle);
+  }
+
+  // Queues a task to be started by schedule(). Its frame is destroyed when
+  // it finishes.
+  void spawn(Task<> task) {
+    post(std::move(task).release());
+  }
+
+  // Resumes one ready task, chosen at random; with none ready, first moves
+  // the clock to the next timer. Returns false once nothing is left to run
+  // or wait for.
+  bool schedule() {
+    if (m_ready.empty()) {
+      if (m_timers.empty())
+        return false;
+      advance();
+    }
+    auto task = pop_ready();
+    if (!task.done())
+      task.resume();
+    return !m_ready.empty() || !m_timers.empty();
+  }
+
+  // Runs everything due up to `deadline` and leaves the clock there.
+  void run_until(time_point deadline) {
+    while (true) {
+      if (m_ready.empty()) {
+        if (m_timers.empty() || m_timers.begin()->first.first > deadline)
+          break;
+        advance();
+      }
+      auto task = pop_ready();
+      if (!task.done())
+        task.resume();
+    }
+    if (m_now < deadline)
+      m_now = deadline;
+  }
+
+  auto suspend() {
+    struct awaiter : std::suspend_always {
+      SimulatedScheduler &scheduler;
+      constexpr awaiter(SimulatedScheduler &s) noexcept : scheduler{s} {}
+      void await_suspend(std::coroutine_handle<> handle) {
+        scheduler.post(handle);
+      }
+    };
+    return awaiter{*this};
+  }
+
+  sleep_awaiter sleep_until(time_point deadline) {
+    return sleep_awaiter{*this, deadline};
+  }
+  sleep_awaiter sleep_for(duration length) {
+    return sleep_until(m_now + length);
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_SIMULATED_SCHEDULER_HPP
@@ -0,0 +1,338 @@
+#ifndef GKXX_CORO_SOCKET_HPP
+#define GKXX_CORO_SOCKET_HPP
+
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "reactor.hpp"
+#include "scheduler.hpp"
+
+namespace gkxx {
+
+class Socket;
+
+namespace detail {
+
+  [[noreturn]] inline void throw_errno(int error, const char *what) {
+    throw std::system_error(error, std::system_category(), what);
+  }
+
+  // Common part of the socket awaiters. `Derived::attempt()` makes one
+  // non-blocking system call with the result and errno conventions of
+  // read(2); it is retried by the reactor after every edge until it stops
+  // failing with EAGAIN.
+  template <typename Derived, Reactor::direction Dir>
+  class socket_operation : public IoOperation {
+    static bool perform_op(IoOperation &op) noexcept {
+      auto &self = static_cast<Derived &>(op);
+      while (true) {
+        auto ret = self.attempt();
+        if (ret >= 0) {
+          self.m_result = ret;
+          return true;
+        }
+        if (errno == EINTR)
+          continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return false;
+        self.m_error = errno;
+        return true;
+      }
+    }
+
+   protected:
+    Scheduler &m_scheduler;
+    int m_fd;
+    ::ssize_t m_result = 0;
+    int m_error = 0;
+
+    void check(const char *what) const {
+      if (m_error != 0)
+        throw_errno(m_error, what);
+    }
+
+   public:
+    socket_operation(Scheduler &scheduler, int fd) noexcept
+        : IoOperation{&perform_op}, m_scheduler{scheduler}, m_fd{fd} {}
+    socket_operation(const socket_operation &) = delete;
+    ~socket_operation() {
+      m_scheduler.m_reactor.cancel(m_fd, Dir, *this);
+    }
+
+    bool await_ready() noexcept {
+      return perform_op(*this);
+    }
+    void await_suspend(std::coroutine_handle<> handle) {
+      this->handle = handle;
+      m_scheduler.m_reactor.wait(m_fd, Dir, *this);
+    }
+  };
+
+} // namespace detail
+
+// Non-blocking stream socket (TCP or Unix domain) driven by the reactor of
+// a Scheduler. At most one read and one write may be pending at a time.
+class Socket {
+  Scheduler *m_scheduler = nullptr;
+  int m_fd = -1;
+
+  static int open_socket(int domain) {
+    auto fd = ::socket(domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+      detail::throw_errno(errno, "socket");
+    return fd;
+  }
+  static ::sockaddr_in loopback(std::uint16_t port) noexcept {
+    ::sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+  }
+  static ::sockaddr_un unix_address(const std::string &path) {
+    ::sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+      detail::throw_errno(ENAMETOOLONG, "socket path");
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+  }
+
+  template <typename Address>
+  static Socket listen_on(Scheduler &scheduler, int domain,
+                          const Address &addr, int backlog) {
+    Socket ret{scheduler, open_socket(domain)};
+    int one = 1;
+    ::setsockopt(ret.m_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(ret.m_fd, reinterpret_cast<const ::sockaddr *>(&addr),
+               sizeof(addr)) < 0)
+      detail::throw_errno(errno, "bind");
+    if (::listen(ret.m_fd, backlog) < 0)
+      detail::throw_errno(errno, "listen");
+    return ret;
+  }
+
+  class read_awaiter
+      : public detail::socket_operation<read_awaiter,
+                                        Reactor::direction::read> {
+    std::span<std::byte> m_buffer;
+
+   public:
+    read_awaiter(Scheduler &scheduler, int fd, std::span<std::byte> buffer)
+        : socket_operation{scheduler, fd}, m_buffer{buffer} {}
+
+    ::ssize_t attempt() noexcept {
+      return ::recv(m_fd, m_buffer.data(), m_buffer.size(), 0);
+    }
+    std::size_t await_resume() const {
+      check("recv");
+      return static_cast<std::size_t>(m_result);
+    }
+  };
+
+  class write_awaiter
+      : public detail::socket_operation<write_awaiter,
+                                        Reactor::direction::write> {
+    std::span<const std::byte> m_buffer;
+
+   public:
+    write_awaiter(Scheduler &scheduler, int fd,
+                  std::span<const std::byte> buffer)
+        : socket_operation{scheduler, fd}, m_buffer{buffer} {}
+
+    ::ssize_t attempt() noexcept {
+      return ::send(m_fd, m_buffer.data(), m_buffer.size(), MSG_NOSIGNAL);
+    }
+    std::size_t await_resume() const {
+      check("send");
+      return static_cast<std::size_t>(m_result);
+    }
+  };
+
+  class accept_awaiter
+      : public detail::socket_operation<accept_awaiter,
+                                        Reactor::direction::read> {
+   public:
+    using socket_operation::socket_operation;
+
+    ::ssize_t attempt() noexcept {
+      return ::accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+    Socket await_resume() const {
+      check("accept");
+      auto fd = static_cast<int>(m_result);
+      int one = 1;
+      // Fails harmlessly on Unix domain sockets.
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      return Socket{m_scheduler, fd};
+    }
+  };
+
+  // connect(2) has already been called on the registered socket `m_fd`;
+  // this waits for it to finish and closes the socket if it fails.
+  class connect_awaiter
+      : public detail::socket_operation<connect_awaiter,
+                                        Reactor::direction::write> {
+    int m_connect_error;
+    bool m_waited = false;
+
+   public:
+    connect_awaiter(Scheduler &scheduler, int fd, int connect_error) noexcept
+        : socket_operation{scheduler, fd}, m_connect_error{connect_error} {}
+    ~connect_awaiter() {
+      if (m_fd >= 0) {
+        m_scheduler.m_reactor.remove(m_fd);
+        ::close(m_fd);
+      }
+    }
+
+    ::ssize_t attempt() noexcept {
+      if (m_connect_error == EINPROGRESS) {
+        // Nothing to check before the socket has turned writable.
+        if (!std::exchange(m_waited, true)) {
+          errno = EAGAIN;
+          return -1;
+        }
+        int error = 0;
+        ::socklen_t len = sizeof(error);
+        ::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        m_connect_error = error;
+      }
+      errno = m_connect_error;
+      return m_connect_error == 0 ? 0 : -1;
+    }
+    Socket await_resume() {
+      check("connect");
+      return Socket{m_scheduler, std::exchange(m_fd, -1), adopt};
+    }
+  };
+
+  template <typename Address>
+  static connect_awaiter connect_to(Scheduler &scheduler, int domain,
+                                    const Address &addr) {
+    auto fd = open_socket(domain);
+    auto error = ::connect(fd, reinterpret_cast<const ::sockaddr *>(&addr),
+                           sizeof(addr)) == 0
+                     ? 0
+                     : errno;
+    if (error == EINTR)
+      error = EINPROGRESS;
+    try {
+      scheduler.m_reactor.add(fd);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    return connect_awaiter{scheduler, fd, error};
+  }
+
+  struct adopt_t {};
+  static constexpr adopt_t adopt{};
+  // Takes over a socket that is already registered with the reactor.
+  Socket(Scheduler &scheduler, int fd, adopt_t) noexcept
+      : m_scheduler{&scheduler}, m_fd{fd} {}
+
+ public:
+  Socket() noexcept = default;
+  // Adopts a non-blocking socket and registers it with the reactor of
+  // `scheduler`.
+  Socket(Scheduler &scheduler, int fd) : m_scheduler{&scheduler}, m_fd{fd} {
+    try {
+      scheduler.m_reactor.add(fd);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+  }
+  Socket(const Socket &) = delete;
+  Socket(Socket &&other) noexcept
+      : m_scheduler{other.m_scheduler}, m_fd{std::exchange(other.m_fd, -1)} {}
+  void swap(Socket &other) noexcept {
+    std::swap(m_scheduler, other.m_scheduler);
+    std::swap(m_fd, other.m_fd);
+  }
+  Socket &operator=(Socket other) noexcept {
+    other.swap(*this);
+    return *this;
+  }
+  ~Socket() {
+    close();
+  }
+
+  void close() noexcept {
+    if (m_fd >= 0) {
+      m_scheduler->m_reactor.remove(m_fd);
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+  bool is_open() const noexcept {
+    return m_fd >= 0;
+  }
+  int native_handle() const noexcept {
+    return m_fd;
+  }
+
+  // Listens on 127.0.0.1:`port`; port 0 picks a free one, see local_port().
+  static Socket listen_tcp(Scheduler &scheduler, std::uint16_t port,
+                           int backlog = SOMAXCONN) {
+    return listen_on(scheduler, AF_INET, loopback(port), backlog);
+  }
+  static Socket listen_unix(Scheduler &scheduler, const std::string &path,
+                            int backlog = SOMAXCONN) {
+    ::unlink(path.c_str());
+    return listen_on(scheduler, AF_UNIX, unix_address(path), backlog);
+  }
+
+  std::uint16_t local_port() const {
+    ::sockaddr_in addr{};
+    ::socklen_t len = sizeof(addr);
+    if (::getsockname(m_fd, reinterpret_cast<::sockaddr *>(&addr), &len) < 0)
+      detail::throw_errno(errno, "getsockname");
+    return ntohs(addr.sin_port);
+  }
+
+  // co_await connect_tcp(...) yields the connected Socket.
+  static connect_awaiter connect_tcp(Scheduler &scheduler,
+                                     std::uint16_t port) {
+    return connect_to(scheduler, AF_INET, loopback(port));
+  }
+  static connect_awaiter connect_unix(Scheduler &scheduler,
+                                      const std::string &path) {
+    return connect_to(scheduler, AF_UNIX, unix_address(path));
+  }
+
+  // co_await accept() yields the accepted Socket.
+  accept_awaiter accept() noexcept {
+    return {*m_scheduler, m_fd};
+  }
+  // co_await read(buffer) yields the number of bytes read; 0 means the peer
+  // has closed the connection.
+  read_awaiter read(std::span<std::byte> buffer) noexcept {
+    return {*m_scheduler, m_fd, buffer};
+  }
+  // co_await write(buffer) yields the number of bytes written, which may be
+  // less than the size of the buffer.
+  write_awaiter write(std::span<const std::byte> buffer) noexcept {
+    return {*m_scheduler, m_fd, buffer};
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_SOCKET_HPP
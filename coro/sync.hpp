@@ -0,0 +1,319 @@
+#ifndef GKXX_CORO_SYNC_HPP
+#define GKXX_CORO_SYNC_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "scheduler.hpp"
+
+namespace gkxx {
+
+namespace detail {
+
+  // Waiting coroutine, linked from its awaiter, i.e. from its own frame.
+  struct sync_waiter {
+    sync_waiter *next = nullptr;
+    std::coroutine_handle<> handle{};
+  };
+
+  // The primitives below may be released from any thread, so waiters go
+  // back through the executor's thread-safe entry point.
+  template <typename Executor>
+  void requeue(Executor &executor, std::coroutine_handle<> handle) {
+    if constexpr (requires { executor.submit(handle); })
+      executor.submit(handle);
+    else
+      executor.post(handle);
+  }
+
+  // Reverses a LIFO stack of waiters into FIFO order.
+  inline sync_waiter *reverse(sync_waiter *stack) noexcept {
+    sync_waiter *ret = nullptr;
+    while (stack)
+      ret = std::exchange(stack, std::exchange(stack->next, ret));
+    return ret;
+  }
+
+} // namespace detail
+
+template <typename Mutex>
+class AsyncLockGuard {
+  Mutex *m_mutex;
+
+ public:
+  explicit AsyncLockGuard(Mutex &mutex) noexcept : m_mutex{&mutex} {}
+  AsyncLockGuard(AsyncLockGuard &&other) noexcept
+      : m_mutex{std::exchange(other.m_mutex, nullptr)} {}
+  AsyncLockGuard &operator=(AsyncLockGuard) = delete;
+  ~AsyncLockGuard() {
+    if (m_mutex)
+      m_mutex->unlock();
+  }
+};
+
+// Mutex whose lock() suspends the awaiting task instead of blocking the
+// thread. The state word is either `not_locked`, `locked_no_waiters`, or
+// the head of a lock-free LIFO stack of tasks that arrived while it was
+// locked. The holder alone owns `m_waiters`, a FIFO it refills by taking
+// the whole stack in one exchange when it runs out, so popping never races
+// and ownership is handed to waiters in arrival order.
+template <typename Executor = Scheduler>
+class AsyncMutex {
+  static constexpr std::uintptr_t not_locked = 1;
+  static constexpr std::uintptr_t locked_no_waiters = 0;
+
+  Executor &m_executor;
+  std::atomic<std::uintptr_t> m_state{not_locked};
+  detail::sync_waiter *m_waiters = nullptr;
+
+  struct lock_awaiter : detail::sync_waiter {
+    AsyncMutex &mutex;
+
+    explicit lock_awaiter(AsyncMutex &m) noexcept : mutex{m} {}
+
+    bool await_ready() const noexcept {
+      return mutex.try_lock();
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      handle = awaiting;
+      auto state = mutex.m_state.load(std::memory_order_acquire);
+      while (true) {
+        if (state == not_locked) {
+          if (mutex.m_state.compare_exchange_weak(
+                  state, locked_no_waiters, std::memory_order_acquire,
+                  std::memory_order_relaxed))
+            return false;
+        } else {
+          next = reinterpret_cast<detail::sync_waiter *>(state);
+          if (mutex.m_state.compare_exchange_weak(
+                  state, reinterpret_cast<std::uintptr_t>(
+                             static_cast<detail::sync_waiter *>(this)),
+                  std::memory_order_release, std::memory_order_relaxed))
+            return true;
+        }
+      }
+    }
+    void await_resume() const noexcept {}
+  };
+
+  struct scoped_lock_awaiter : lock_awaiter {
+    using lock_awaiter::lock_awaiter;
+    [[nodiscard]] AsyncLockGuard<AsyncMutex> await_resume() const noexcept {
+      return AsyncLockGuard<AsyncMutex>{this->mutex};
+    }
+  };
+
+ public:
+  explicit AsyncMutex(Executor &executor) noexcept : m_executor{executor} {}
+  AsyncMutex(const AsyncMutex &) = delete;
+  AsyncMutex &operator=(const AsyncMutex &) = delete;
+
+  bool try_lock() noexcept {
+    auto expected = not_locked;
+    return m_state.compare_exchange_strong(expected, locked_no_waiters,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed);
+  }
+
+  // co_await mutex.lock(); ... mutex.unlock();
+  [[nodiscard]] lock_awaiter lock() noexcept {
+    return lock_awaiter{*this};
+  }
+  // auto guard = co_await mutex.scoped_lock();
+  [[nodiscard]] scoped_lock_awaiter scoped_lock() noexcept {
+    return scoped_lock_awaiter{*this};
+  }
+
+  // Hands the lock to the longest waiting task, if any, and requeues it on
+  // the executor.
+  void unlock() {
+    if (!m_waiters) {
+      auto state = locked_no_waiters;
+      if (m_state.compare_exchange_strong(state, not_locked,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+        return;
+      state = m_state.exchange(locked_no_waiters, std::memory_order_acquire);
+      m_waiters =
+          detail::reverse(reinterpret_cast<detail::sync_waiter *>(state));
+    }
+    auto next = std::exchange(m_waiters, m_waiters->next);
+    detail::requeue(m_executor, next->handle);
+  }
+};
+
+// Counting semaphore whose acquire() suspends the awaiting task. Like
+// AsyncMutex, the state word holds either the available count (tagged with
+// the low bit) or a lock-free stack of newly arrived waiters. Releases are
+// combined: whoever sets `m_releasing` hands out every pending release,
+// first to the FIFO of earlier waiters that only it touches, so concurrent
+// releases never pop the stack and it has no ABA problem.
+template <typename Executor = Scheduler>
+class AsyncSemaphore {
+  Executor &m_executor;
+  // (count << 1) | 1, or a waiter stack (nullptr when the count is 0).
+  std::atomic<std::uintptr_t> m_state;
+  std::atomic<std::size_t> m_pending{0};
+  std::atomic<bool> m_releasing{false};
+  detail::sync_waiter *m_waiters = nullptr;
+
+  static constexpr std::uintptr_t count_state(std::size_t count) noexcept {
+    return count == 0 ? 0 : (static_cast<std::uintptr_t>(count) << 1) | 1;
+  }
+
+  struct acquire_awaiter : detail::sync_waiter {
+    AsyncSemaphore &semaphore;
+
+    explicit acquire_awaiter(AsyncSemaphore &s) noexcept : semaphore{s} {}
+
+    bool await_ready() const noexcept {
+      return semaphore.try_acquire();
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      handle = awaiting;
+      auto &state = semaphore.m_state;
+      auto s = state.load(std::memory_order_acquire);
+      while (true) {
+        if (s & 1) {
+          if (state.compare_exchange_weak(s, count_state((s >> 1) - 1),
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed))
+            return false;
+        } else {
+          next = reinterpret_cast<detail::sync_waiter *>(s);
+          if (state.compare_exchange_weak(
+                  s, reinterpret_cast<std::uintptr_t>(
+                         static_cast<detail::sync_waiter *>(this)),
+                  std::memory_order_release, std::memory_order_acquire))
+            return true;
+        }
+      }
+    }
+    void await_resume() const noexcept {}
+  };
+
+  // Hands out `n` releases; only called with `m_releasing` held.
+  void hand_out(std::size_t n) {
+    while (n != 0) {
+      if (m_waiters) {
+        auto waiter = std::exchange(m_waiters, m_waiters->next);
+        detail::requeue(m_executor, waiter->handle);
+        --n;
+        continue;
+      }
+      auto s = m_state.load(std::memory_order_acquire);
+      if (s & 1 || s == 0) {
+        if (m_state.compare_exchange_weak(s, count_state((s >> 1) + n),
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+          return;
+      } else {
+        m_waiters = detail::reverse(reinterpret_cast<detail::sync_waiter *>(
+            m_state.exchange(0, std::memory_order_acquire)));
+      }
+    }
+  }
+
+ public:
+  explicit AsyncSemaphore(Executor &executor, std::size_t initial = 0) noexcept
+      : m_executor{executor}, m_state{count_state(initial)} {}
+  AsyncSemaphore(const AsyncSemaphore &) = delete;
+  AsyncSemaphore &operator=(const AsyncSemaphore &) = delete;
+
+  bool try_acquire() noexcept {
+    auto s = m_state.load(std::memory_order_acquire);
+    while (s & 1)
+      if (m_state.compare_exchange_weak(s, count_state((s >> 1) - 1),
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire))
+        return true;
+    return false;
+  }
+
+  [[nodiscard]] acquire_awaiter acquire() noexcept {
+    return acquire_awaiter{*this};
+  }
+
+  // Wakes up to `n` waiting tasks, in arrival order, and keeps the rest of
+  // the count for later acquires.
+  void release(std::size_t n = 1) {
+    m_pending.fetch_add(n, std::memory_order_seq_cst);
+    while (!m_releasing.exchange(true, std::memory_order_seq_cst)) {
+      hand_out(m_pending.exchange(0, std::memory_order_seq_cst));
+      m_releasing.store(false, std::memory_order_seq_cst);
+      if (m_pending.load(std::memory_order_seq_cst) == 0)
+        break;
+    }
+  }
+};
+
+// Event that stays set until reset(). Awaiting it suspends the task while
+// it is not set; set() requeues every waiting task. The state word is
+// `this` when set, or the stack of waiters otherwise.
+template <typename Executor = Scheduler>
+class AsyncManualResetEvent {
+  Executor &m_executor;
+  mutable std::atomic<void *> m_state;
+
+  struct awaiter : detail::sync_waiter {
+    const AsyncManualResetEvent &event;
+
+    explicit awaiter(const AsyncManualResetEvent &e) noexcept : event{e} {}
+
+    bool await_ready() const noexcept {
+      return event.is_set();
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      handle = awaiting;
+      auto &state = event.m_state;
+      auto s = state.load(std::memory_order_acquire);
+      do {
+        if (s == &event)
+          return false;
+        next = static_cast<detail::sync_waiter *>(s);
+      } while (!state.compare_exchange_weak(
+          s, static_cast<detail::sync_waiter *>(this),
+          std::memory_order_release, std::memory_order_acquire));
+      return true;
+    }
+    void await_resume() const noexcept {}
+  };
+
+ public:
+  explicit AsyncManualResetEvent(Executor &executor,
+                                 bool initially_set = false) noexcept
+      : m_executor{executor},
+        m_state{initially_set ? static_cast<void *>(this) : nullptr} {}
+  AsyncManualResetEvent(const AsyncManualResetEvent &) = delete;
+  AsyncManualResetEvent &operator=(const AsyncManualResetEvent &) = delete;
+
+  bool is_set() const noexcept {
+    return m_state.load(std::memory_order_acquire) == this;
+  }
+
+  void set() {
+    auto s = m_state.exchange(this, std::memory_order_acq_rel);
+    if (s == this)
+      return;
+    for (auto w = detail::reverse(static_cast<detail::sync_waiter *>(s)); w;)
+      detail::requeue(m_executor, std::exchange(w, w->next)->handle);
+  }
+
+  // Does nothing unless the event is set.
+  void reset() noexcept {
+    void *expected = this;
+    m_state.compare_exchange_strong(expected, nullptr,
+                                    std::memory_order_relaxed);
+  }
+
+  awaiter operator co_await() const noexcept {
+    return awaiter{*this};
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_SYNC_HPP
@@ -0,0 +1,330 @@
+#ifndef GKXX_CORO_TASK_HPP
+#define GKXX_CORO_TASK_HPP
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "frame_pool.hpp"
+
+namespace gkxx {
+
+template <typename Type = void>
+class Task;
+
+namespace detail {
+
+  // Completion hook for combinators such as when_all: when set, it is called
+  // instead of resuming the continuation, and returns the handle to resume.
+  struct task_notifier {
+    std::coroutine_handle<> (*notify)(task_notifier &) noexcept;
+  };
+
+  struct task_access;
+
+  class task_promise_base {
+    enum class state { owned, detached, finished };
+
+    std::coroutine_handle<> m_continuation{};
+    std::atomic<task_notifier *> m_notifier{nullptr};
+    std::atomic<state> m_state{state::owned};
+
+    template <typename>
+    friend class ::gkxx::Task;
+    friend struct task_access;
+
+    // Resumes whoever awaits the task by returning its handle from
+    // await_suspend, so a chain of co_returns never grows the stack. A
+    // detached task destroys its own frame here.
+    struct final_awaiter {
+      bool await_ready() const noexcept {
+        return false;
+      }
+      template <typename Promise>
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+        auto &promise = handle.promise();
+        // Taking the notifier out races with task_access::revoke(). Whoever
+        // set it owns the task and may destroy it as soon as it has been
+        // notified, so the promise is not touched afterwards.
+        if (promise.m_notifier.load(std::memory_order_acquire))
+          if (auto notifier = promise.m_notifier.exchange(
+                  nullptr, std::memory_order_acq_rel)) {
+            promise.m_state.store(state::finished, std::memory_order_release);
+            return notifier->notify(*notifier);
+          }
+        auto continuation = promise.m_continuation;
+        if (promise.m_state.exchange(state::finished,
+                                     std::memory_order_acq_rel) ==
+            state::detached) {
+          handle.destroy();
+          return std::noop_coroutine();
+        }
+        return continuation ? continuation : std::noop_coroutine();
+      }
+      void await_resume() const noexcept {}
+    };
+
+   public:
+#ifndef GKXX_CORO_NO_FRAME_POOL
+    // Frames come from the allocating thread's FramePool.
+    static void *operator new(std::size_t size) {
+      return FramePool::allocate(size);
+    }
+    static void operator delete(void *frame) noexcept {
+      FramePool::deallocate(frame);
+    }
+#endif
+
+    std::suspend_always initial_suspend() const noexcept {
+      return {};
+    }
+    final_awaiter final_suspend() const noexcept {
+      return {};
+    }
+  };
+
+  template <typename Type>
+  class task_promise : public task_promise_base {
+    std::variant<std::monostate, Type, std::exception_ptr> m_result;
+
+   public:
+    Task<Type> get_return_object() noexcept;
+
+    template <typename U = Type>
+      requires std::is_convertible_v<U &&, Type>
+    void return_value(U &&value) noexcept(
+        std::is_nothrow_constructible_v<Type, U &&>) {
+      m_result.template emplace<1>(std::forward<U>(value));
+    }
+    void unhandled_exception() noexcept {
+      m_result.template emplace<2>(std::current_exception());
+    }
+
+    Type &result() & {
+      if (m_result.index() == 2)
+        std::rethrow_exception(std::get<2>(m_result));
+      return std::get<1>(m_result);
+    }
+    Type &&result() && {
+      return std::move(result());
+    }
+  };
+
+  template <>
+  class task_promise<void> : public task_promise_base {
+    std::exception_ptr m_exception;
+
+   public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+    void unhandled_exception() noexcept {
+      m_exception = std::current_exception();
+    }
+
+    void result() const {
+      if (m_exception)
+        std::rethrow_exception(m_exception);
+    }
+  };
+
+} // namespace detail
+
+// A lazily started coroutine that produces a value of type `Type`. Awaiting
+// it starts it; when it finishes, it resumes the awaiting coroutine through
+// symmetric transfer.
+template <typename Type>
+class [[nodiscard]] Task {
+  static_assert(!std::is_reference_v<Type>,
+                "Task does not support reference results");
+
+ public:
+  using promise_type = detail::task_promise<Type>;
+  using value_type = Type;
+
+ private:
+  using handle_type = std::coroutine_handle<promise_type>;
+  handle_type m_coro_handle;
+
+  friend promise_type;
+  friend struct detail::task_access;
+  explicit Task(handle_type handle) noexcept : m_coro_handle{handle} {}
+
+  template <bool Move>
+  struct awaiter {
+    handle_type callee;
+
+    bool await_ready() const noexcept {
+      assert(callee && "awaiting an empty Task");
+      return callee.done();
+    }
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<> caller) const noexcept {
+      callee.promise().m_continuation = caller;
+      return callee;
+    }
+    decltype(auto) await_resume() const {
+      if constexpr (std::is_void_v<Type>)
+        return callee.promise().result();
+      else if constexpr (Move)
+        return Type(std::move(callee.promise()).result());
+      else
+        return callee.promise().result();
+    }
+  };
+
+ public:
+  Task() noexcept = default;
+  Task(const Task &) = delete;
+  Task(Task &&other) noexcept
+      : m_coro_handle{std::exchange(other.m_coro_handle, nullptr)} {}
+  void swap(Task &other) noexcept {
+    std::swap(m_coro_handle, other.m_coro_handle);
+  }
+  Task &operator=(Task other) noexcept {
+    other.swap(*this);
+    return *this;
+  }
+  ~Task() {
+    if (m_coro_handle)
+      m_coro_handle.destroy();
+  }
+
+  bool is_ready() const noexcept {
+    return !m_coro_handle || m_coro_handle.done();
+  }
+
+  // The Task must not be empty.
+  auto operator co_await() & noexcept {
+    return awaiter<false>{m_coro_handle};
+  }
+  auto operator co_await() && noexcept {
+    return awaiter<true>{m_coro_handle};
+  }
+
+  // Gives up ownership of a task that has not been started. The frame
+  // destroys itself when the task finishes; the returned handle starts it.
+  std::coroutine_handle<> release() && noexcept {
+    assert(m_coro_handle && "releasing an empty Task");
+    auto handle = std::exchange(m_coro_handle, nullptr);
+    handle.promise().m_state.store(promise_type::state::detached,
+                                   std::memory_order_relaxed);
+    return handle;
+  }
+
+  // Gives up ownership of a task that may be running on another thread.
+  // Whichever of detach() and the task's completion comes second destroys
+  // the frame.
+  void detach() noexcept {
+    auto handle = std::exchange(m_coro_handle, nullptr);
+    if (handle &&
+        handle.promise().m_state.exchange(promise_type::state::detached,
+                                          std::memory_order_acq_rel) ==
+            promise_type::state::finished)
+      handle.destroy();
+  }
+};
+
+namespace detail {
+
+  template <typename Type>
+  inline Task<Type> task_promise<Type>::get_return_object() noexcept {
+    return Task<Type>{std::coroutine_handle<task_promise>::from_promise(*this)};
+  }
+
+  inline Task<void> task_promise<void>::get_return_object() noexcept {
+    return Task<void>{std::coroutine_handle<task_promise>::from_promise(*this)};
+  }
+
+  struct task_access {
+    // Starts `task` with `notifier` to be called when it finishes.
+    template <typename Type>
+    static void start(Task<Type> &task, task_notifier &notifier) {
+      auto handle = task.m_coro_handle;
+      handle.promise().m_notifier.store(&notifier, std::memory_order_relaxed);
+      handle.resume();
+    }
+    // Takes the notifier back from a started task. Returns false if the
+    // task has already taken it to call it, or is about to.
+    template <typename Type>
+    static bool revoke(Task<Type> &task) noexcept {
+      return task.m_coro_handle.promise().m_notifier.exchange(
+                 nullptr, std::memory_order_acq_rel) != nullptr;
+    }
+    // Result of a finished task; rethrows its exception.
+    template <typename Type>
+    static decltype(auto) result(Task<Type> &task) {
+      if constexpr (std::is_void_v<Type>)
+        task.m_coro_handle.promise().result();
+      else
+        return std::move(task.m_coro_handle.promise()).result();
+    }
+  };
+
+  struct sync_wait_event {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    void set() {
+      std::lock_guard lock{mutex};
+      done = true;
+      cv.notify_all();
+    }
+    void wait() {
+      std::unique_lock lock{mutex};
+      cv.wait(lock, [this] { return done; });
+    }
+  };
+
+  template <typename Type, typename Storage>
+  Task<void> sync_wait_driver(Task<Type> &task, Storage &result,
+                              std::exception_ptr &exception,
+                              sync_wait_event &event) {
+    try {
+      if constexpr (std::is_void_v<Type>)
+        co_await std::move(task);
+      else
+        result.template emplace<1>(co_await std::move(task));
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    event.set();
+  }
+
+} // namespace detail
+
+// Runs `task` on `executor` and blocks until it finishes. With a
+// single-threaded Scheduler the calling thread drives schedule() itself.
+template <typename Executor, typename Type>
+Type sync_wait(Executor &executor, Task<Type> task) {
+  using storage = std::conditional_t<std::is_void_v<Type>,
+                                     std::variant<std::monostate>,
+                                     std::variant<std::monostate, Type>>;
+  storage result;
+  std::exception_ptr exception;
+  detail::sync_wait_event event;
+  executor.post(
+      detail::sync_wait_driver(task, result, exception, event).release());
+  if constexpr (requires { executor.schedule(); }) {
+    while (!event.done)
+      executor.schedule();
+  } else {
+    event.wait();
+  }
+  if (exception)
+    std::rethrow_exception(exception);
+  if constexpr (!std::is_void_v<Type>)
+    return std::get<1>(std::move(result));
+}
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_TASK_HPP
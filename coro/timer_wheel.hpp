@@ -0,0 +1,197 @@
+#ifndef GKXX_CORO_TIMER_WHEEL_HPP
+#define GKXX_CORO_TIMER_WHEEL_HPP
+
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "../tictoc.hpp"
+
+namespace gkxx {
+
+// Intrusive timer entry. It lives wherever the waiter lives (usually in the
+// awaiter inside a coroutine frame), so arming a timer allocates nothing.
+struct TimerNode {
+  TimerNode *prev = nullptr;
+  TimerNode *next = nullptr;
+  std::uint64_t expiry = 0;
+  std::coroutine_handle<> handle{};
+
+  bool is_linked() const noexcept {
+    return prev != nullptr;
+  }
+};
+
+// Hierarchical timing wheel: four levels of 64 slots over ticks of a fixed
+// resolution (1ms by default), covering 2^24 ticks before timers have to be
+// re-filed. Inserting and cancelling are O(1) list operations; a timer in an
+// outer level is moved inward once when its slot comes due.
+class TimerWheel {
+ public:
+  using clock_type = Clock::clock_type;
+  using time_point = clock_type::time_point;
+  using duration = clock_type::duration;
+
+ private:
+  static constexpr unsigned slot_bits = 6;
+  static constexpr std::size_t slots = std::size_t{1} << slot_bits;
+  static constexpr unsigned levels = 4;
+  static constexpr std::uint64_t slot_mask = slots - 1;
+
+  struct list_head {
+    TimerNode node{&node, &node};
+
+    list_head() = default;
+    list_head(const list_head &) = delete;
+
+    bool empty() const noexcept {
+      return node.next == &node;
+    }
+  };
+
+  Clock m_origin;
+  duration m_resolution;
+  std::uint64_t m_current = 0;
+  std::size_t m_size = 0;
+  std::array<std::array<list_head, slots>, levels> m_wheel;
+
+  static void link(list_head &head, TimerNode &node) noexcept {
+    node.prev = head.node.prev;
+    node.next = &head.node;
+    head.node.prev->next = &node;
+    head.node.prev = &node;
+  }
+  static void unlink(TimerNode &node) noexcept {
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = node.next = nullptr;
+  }
+
+  void file(TimerNode &node) noexcept {
+    auto expiry = node.expiry > m_current ? node.expiry : m_current + 1;
+    auto delta = expiry - m_current;
+    for (unsigned level = 0; level != levels; ++level) {
+      if (delta < (std::uint64_t{1} << (slot_bits * (level + 1)))) {
+        link(m_wheel[level][(expiry >> (slot_bits * level)) & slot_mask],
+             node);
+        return;
+      }
+    }
+    // Too far away: park it in the outermost slot that comes due last; it is
+    // filed again with its real expiry when that slot cascades.
+    auto last = m_current + (std::uint64_t{1} << (slot_bits * levels)) - 1;
+    link(m_wheel[levels - 1][(last >> (slot_bits * (levels - 1))) & slot_mask],
+         node);
+  }
+
+  void cascade(unsigned level) noexcept {
+    auto &head = m_wheel[level][(m_current >> (slot_bits * level)) & slot_mask];
+    while (!head.empty()) {
+      auto &node = *head.node.next;
+      unlink(node);
+      file(node);
+    }
+  }
+
+ public:
+  explicit TimerWheel(duration resolution = std::chrono::milliseconds{1})
+      : m_origin{tic()}, m_resolution{resolution} {}
+
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  bool empty() const noexcept {
+    return m_size == 0;
+  }
+  std::size_t size() const noexcept {
+    return m_size;
+  }
+
+  std::uint64_t to_tick(time_point tp) const noexcept {
+    if (tp <= m_origin.start_time)
+      return 0;
+    // Round up so that a timer never fires before its deadline.
+    return static_cast<std::uint64_t>(
+        (tp - m_origin.start_time + m_resolution - duration{1}) /
+        m_resolution);
+  }
+  time_point to_time_point(std::uint64_t tick) const noexcept {
+    return m_origin.start_time + m_resolution * tick;
+  }
+
+  void insert(TimerNode &node, time_point deadline) noexcept {
+    node.expiry = to_tick(deadline);
+    file(node);
+    ++m_size;
+  }
+
+  void cancel(TimerNode &node) noexcept {
+    if (node.is_linked()) {
+      unlink(node);
+      --m_size;
+    }
+  }
+
+  // Earliest time at which some timer may be due. For timers in outer
+  // levels this is the start of their slot, which is early but never late.
+  // An outer slot may come due before the first non-empty inner one, so
+  // every level is looked at.
+  std::optional<time_point> next_deadline() const noexcept {
+    if (m_size == 0)
+      return std::nullopt;
+    std::optional<std::uint64_t> earliest;
+    for (unsigned level = 0; level != levels; ++level) {
+      auto shift = slot_bits * level;
+      for (std::uint64_t i = 1; i <= slots; ++i) {
+        auto tick = ((m_current >> shift) + i) << shift;
+        if (earliest && tick >= *earliest)
+          break;
+        if (!m_wheel[level][(tick >> shift) & slot_mask].empty()) {
+          earliest = tick;
+          break;
+        }
+      }
+    }
+    return to_time_point(earliest ? *earliest : m_current + 1);
+  }
+
+  // Advances the wheel to `now`, calling `fire(node)` for every expired
+  // timer after unlinking it.
+  template <typename Fire>
+  void advance(time_point now, Fire &&fire) {
+    auto target =
+        now <= m_origin.start_time
+            ? std::uint64_t{0}
+            : static_cast<std::uint64_t>((now - m_origin.start_time) /
+                                         m_resolution);
+    if (m_size == 0) {
+      if (target > m_current)
+        m_current = target;
+      return;
+    }
+    while (m_current < target && m_size != 0) {
+      ++m_current;
+      for (unsigned level = 1; level != levels; ++level) {
+        if ((m_current & ((std::uint64_t{1} << (slot_bits * level)) - 1)) != 0)
+          break;
+        cascade(level);
+      }
+      auto &head = m_wheel[0][m_current & slot_mask];
+      while (!head.empty()) {
+        auto &node = *head.node.next;
+        unlink(node);
+        --m_size;
+        fire(node);
+      }
+    }
+    if (m_current < target)
+      m_current = target;
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_TIMER_WHEEL_HPP
@@ -0,0 +1,167 @@
+#ifndef GKXX_CORO_WHEN_ALL_HPP
+#define GKXX_CORO_WHEN_ALL_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "task.hpp"
+
+namespace gkxx {
+
+namespace detail {
+
+  template <typename Type>
+  using when_result_t =
+      std::conditional_t<std::is_void_v<Type>, std::monostate, Type>;
+
+  template <typename Type>
+  when_result_t<Type> take_when_result(Task<Type> &task) {
+    if constexpr (std::is_void_v<Type>) {
+      task_access::result(task);
+      return {};
+    } else {
+      return task_access::result(task);
+    }
+  }
+
+  template <typename>
+  inline constexpr bool is_task_v = false;
+  template <typename Type>
+  inline constexpr bool is_task_v<Task<Type>> = true;
+
+  // Starts the tasks and resumes the awaiting coroutine when the last one
+  // finishes. The count starts one higher than the number of tasks so that
+  // tasks finishing while the others are still being started cannot resume
+  // the awaiting coroutine early; each completion is one decrement.
+  class when_all_counter : public task_notifier {
+    std::atomic<std::size_t> m_count;
+    std::coroutine_handle<> m_awaiting{};
+
+    static std::coroutine_handle<> on_task_done(task_notifier &n) noexcept {
+      auto &self = static_cast<when_all_counter &>(n);
+      if (self.m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        return self.m_awaiting;
+      return std::noop_coroutine();
+    }
+
+   public:
+    explicit when_all_counter(std::size_t tasks) noexcept
+        : task_notifier{&on_task_done}, m_count{tasks + 1} {}
+
+    // Returns whether the awaiting coroutine has to stay suspended.
+    template <typename StartAll>
+    bool start(std::coroutine_handle<> awaiting, StartAll start_all) {
+      m_awaiting = awaiting;
+      start_all();
+      return m_count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+  };
+
+  template <typename... Types>
+  class when_all_awaiter {
+    std::tuple<Task<Types>...> m_tasks;
+    when_all_counter m_counter{sizeof...(Types)};
+
+   public:
+    explicit when_all_awaiter(Task<Types>... tasks)
+        : m_tasks{std::move(tasks)...} {}
+
+    bool await_ready() const noexcept {
+      return sizeof...(Types) == 0;
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+      return m_counter.start(awaiting, [this] {
+        std::apply(
+            [this](auto &...tasks) {
+              (task_access::start(tasks, m_counter), ...);
+            },
+            m_tasks);
+      });
+    }
+    std::tuple<when_result_t<Types>...> await_resume() {
+      return std::apply(
+          [](auto &...tasks) {
+            return std::tuple<when_result_t<Types>...>{
+                take_when_result(tasks)...};
+          },
+          m_tasks);
+    }
+  };
+
+  template <typename Type>
+  class when_all_range_awaiter {
+    std::vector<Task<Type>> m_tasks;
+    when_all_counter m_counter{m_tasks.size()};
+
+   public:
+    explicit when_all_range_awaiter(std::vector<Task<Type>> tasks)
+        : m_tasks{std::move(tasks)} {}
+
+    bool await_ready() const noexcept {
+      return m_tasks.empty();
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+      return m_counter.start(awaiting, [this] {
+        for (auto &task : m_tasks)
+          task_access::start(task, m_counter);
+      });
+    }
+    auto await_resume() {
+      if constexpr (std::is_void_v<Type>) {
+        for (auto &task : m_tasks)
+          task_access::result(task);
+      } else {
+        std::vector<Type> ret;
+        ret.reserve(m_tasks.size());
+        for (auto &task : m_tasks)
+          ret.push_back(task_access::result(task));
+        return ret;
+      }
+    }
+  };
+
+  template <typename Range>
+  auto collect_tasks(Range &&tasks) {
+    using task_type = std::ranges::range_value_t<Range>;
+    std::vector<task_type> ret;
+    if constexpr (std::ranges::sized_range<Range>)
+      ret.reserve(std::ranges::size(tasks));
+    for (auto &&task : tasks)
+      ret.push_back(std::move(task));
+    return ret;
+  }
+
+} // namespace detail
+
+// co_await when_all(a, b, c) starts the tasks one after another on the
+// awaiting thread and resumes when all of them have finished, yielding a
+// tuple of their results (std::monostate for Task<void>). If some of them
+// failed, the exception of the leftmost one is rethrown. The counter and
+// the results live in the awaiter, i.e. in the awaiting frame, so nothing
+// is allocated.
+template <typename... Types>
+auto when_all(Task<Types>... tasks) {
+  return detail::when_all_awaiter<Types...>{std::move(tasks)...};
+}
+
+// Range form: yields a std::vector of the results, or nothing for
+// Task<void>. The tasks are moved out of the range.
+template <std::ranges::input_range Range>
+  requires detail::is_task_v<std::ranges::range_value_t<Range>>
+auto when_all(Range &&tasks) {
+  using task_type = std::ranges::range_value_t<Range>;
+  return detail::when_all_range_awaiter<typename task_type::value_type>{
+      detail::collect_tasks(std::forward<Range>(tasks))};
+}
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_WHEN_ALL_HPP
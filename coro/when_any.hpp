@@ -0,0 +1,240 @@
+#ifndef GKXX_CORO_WHEN_ANY_HPP
+#define GKXX_CORO_WHEN_ANY_HPP
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <ranges>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "task.hpp"
+#include "when_all.hpp"
+
+namespace gkxx {
+
+namespace detail {
+
+  // Shared by the tasks of one when_any. The first task to finish wins and
+  // resumes the awaiting coroutine, unless the tasks are still being
+  // started, in which case the starter does (`m_gate` counts both sides
+  // down). The others are detached when the awaiter goes away; those that
+  // had already taken their notifier are waited for, so that none of them
+  // touches this state after it is gone.
+  class when_any_state {
+    std::atomic<bool> m_won{false};
+    std::atomic<int> m_gate{2};
+    std::atomic<std::size_t> m_notified{0};
+    std::coroutine_handle<> m_awaiting{};
+    std::size_t m_winner = 0;
+    std::size_t m_started = 0;
+
+   public:
+    struct slot : task_notifier {
+      when_any_state *state = nullptr;
+      std::size_t index = 0;
+
+      slot() noexcept : task_notifier{&on_task_done} {}
+    };
+
+   private:
+    static std::coroutine_handle<> on_task_done(task_notifier &n) noexcept {
+      auto &s = static_cast<slot &>(n);
+      auto &self = *s.state;
+      std::coroutine_handle<> next = std::noop_coroutine();
+      if (!self.m_won.exchange(true, std::memory_order_acq_rel)) {
+        self.m_winner = s.index;
+        auto awaiting = self.m_awaiting;
+        if (self.m_gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          next = awaiting;
+      }
+      // Last access to the state: once the count is reached, release() may
+      // return and the state be freed, so nothing, not even a notify, may
+      // follow it.
+      self.m_notified.fetch_add(1, std::memory_order_acq_rel);
+      return next;
+    }
+
+   public:
+    when_any_state() = default;
+    when_any_state(const when_any_state &) = delete;
+
+    std::size_t winner() const noexcept {
+      return m_winner;
+    }
+
+    // Starts tasks until one of them finishes. Returns whether the
+    // awaiting coroutine has to stay suspended.
+    template <typename StartOne>
+    bool start(std::coroutine_handle<> awaiting, std::size_t count,
+               StartOne start_one) {
+      m_awaiting = awaiting;
+      for (; m_started != count; ++m_started) {
+        if (m_won.load(std::memory_order_acquire))
+          break;
+        start_one(m_started);
+      }
+      return m_gate.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    // Lets go of the started tasks; `revoke(i)` and `detach(i)` act on
+    // task i. Tasks that had already taken their notifier are in the last
+    // few instructions of on_task_done(), so they are waited for by
+    // spinning.
+    template <typename Revoke, typename Detach>
+    void release(Revoke revoke, Detach detach) noexcept {
+      std::size_t notifying = 0;
+      for (std::size_t i = 0; i != m_started; ++i)
+        if (!revoke(i))
+          ++notifying;
+      while (m_notified.load(std::memory_order_acquire) < notifying)
+        std::this_thread::yield();
+      for (std::size_t i = 0; i != m_started; ++i)
+        detach(i);
+    }
+  };
+
+  template <typename... Types>
+  class when_any_awaiter {
+    static constexpr std::size_t count = sizeof...(Types);
+    using result_type = std::variant<when_result_t<Types>...>;
+
+    std::tuple<Task<Types>...> m_tasks;
+    std::array<when_any_state::slot, count> m_slots{};
+    when_any_state m_state{};
+
+    // Calls `f(task)` on task number `i`.
+    template <typename F>
+    void visit_task(std::size_t i, F f) {
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((I == i ? (f(std::get<I>(m_tasks)), 0) : 0), ...);
+      }(std::make_index_sequence<count>{});
+    }
+
+    template <std::size_t... I>
+    static constexpr auto make_take_table(std::index_sequence<I...>) {
+      using taker = result_type (*)(when_any_awaiter &);
+      return std::array<taker, count>{[](when_any_awaiter &self) {
+        return result_type{std::in_place_index<I>,
+                           take_when_result(std::get<I>(self.m_tasks))};
+      }...};
+    }
+    static constexpr auto take_table =
+        make_take_table(std::make_index_sequence<count>{});
+
+   public:
+    explicit when_any_awaiter(Task<Types>... tasks)
+        : m_tasks{std::move(tasks)...} {
+      for (std::size_t i = 0; i != count; ++i) {
+        m_slots[i].state = &m_state;
+        m_slots[i].index = i;
+      }
+    }
+    when_any_awaiter(const when_any_awaiter &) = delete;
+    ~when_any_awaiter() {
+      m_state.release(
+          [this](std::size_t i) {
+            bool revoked = false;
+            visit_task(i, [&](auto &task) {
+              revoked = task_access::revoke(task);
+            });
+            return revoked;
+          },
+          [this](std::size_t i) {
+            visit_task(i, [](auto &task) { task.detach(); });
+          });
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+      return m_state.start(awaiting, count, [this](std::size_t i) {
+        visit_task(i, [&](auto &task) {
+          task_access::start(task, m_slots[i]);
+        });
+      });
+    }
+    result_type await_resume() {
+      return take_table[m_state.winner()](*this);
+    }
+  };
+
+  template <typename Type>
+  class when_any_range_awaiter {
+    std::vector<Task<Type>> m_tasks;
+    std::vector<when_any_state::slot> m_slots;
+    when_any_state m_state{};
+
+   public:
+    explicit when_any_range_awaiter(std::vector<Task<Type>> tasks)
+        : m_tasks{std::move(tasks)}, m_slots(m_tasks.size()) {
+      for (std::size_t i = 0; i != m_slots.size(); ++i) {
+        m_slots[i].state = &m_state;
+        m_slots[i].index = i;
+      }
+    }
+    when_any_range_awaiter(const when_any_range_awaiter &) = delete;
+    ~when_any_range_awaiter() {
+      m_state.release(
+          [this](std::size_t i) { return task_access::revoke(m_tasks[i]); },
+          [this](std::size_t i) { m_tasks[i].detach(); });
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+      return m_state.start(awaiting, m_tasks.size(), [this](std::size_t i) {
+        task_access::start(m_tasks[i], m_slots[i]);
+      });
+    }
+    auto await_resume() {
+      auto winner = m_state.winner();
+      if constexpr (std::is_void_v<Type>) {
+        task_access::result(m_tasks[winner]);
+        return winner;
+      } else {
+        return std::pair<std::size_t, Type>{
+            winner, task_access::result(m_tasks[winner])};
+      }
+    }
+  };
+
+} // namespace detail
+
+// co_await when_any(a, b, c) starts the tasks one after another until one
+// of them finishes and resumes as soon as the first one has finished,
+// yielding its result as a std::variant whose index() tells which task it
+// was (std::monostate for Task<void>); its exception is rethrown. Tasks
+// that have not been started by then never are. The others are not
+// cancelled: they are detached and run to completion on their own. The
+// shared state lives in the awaiting frame, so nothing is allocated.
+template <typename... Types>
+  requires(sizeof...(Types) > 0)
+auto when_any(Task<Types>... tasks) {
+  return detail::when_any_awaiter<Types...>{std::move(tasks)...};
+}
+
+// Range form: yields std::pair{index, result}, or just the index for
+// Task<void>. Throws std::invalid_argument if the range is empty.
+template <std::ranges::input_range Range>
+  requires detail::is_task_v<std::ranges::range_value_t<Range>>
+auto when_any(Range &&tasks) {
+  using task_type = std::ranges::range_value_t<Range>;
+  auto collected = detail::collect_tasks(std::forward<Range>(tasks));
+  if (collected.empty())
+    throw std::invalid_argument("when_any of no tasks");
+  return detail::when_any_range_awaiter<typename task_type::value_type>{
+      std::move(collected)};
+}
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_WHEN_ANY_HPP
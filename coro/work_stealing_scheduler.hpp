@@ -0,0 +1,243 @@
+#ifndef GKXX_CORO_WORK_STEALING_SCHEDULER_HPP
+#define GKXX_CORO_WORK_STEALING_SCHEDULER_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "chase_lev_deque.hpp"
+#include "mpmc_queue.hpp"
+#include "scheduler_metrics.hpp"
+#include "task.hpp"
+
+namespace gkxx {
+
+// Multi-threaded counterpart of Scheduler: one worker thread per core, each
+// owning a Chase-Lev deque. A task spawned or woken on a worker goes to the
+// bottom of that worker's deque (LIFO); idle workers steal from the top of
+// the others' (FIFO). Tasks posted from outside the pool, and tasks that
+// yield with suspend(), go through a shared injection queue, so a yielding
+// task lets the others run first.
+class WorkStealingScheduler {
+  using handle_type = std::coroutine_handle<>;
+
+  struct worker {
+    WorkStealingScheduler *owner;
+    std::size_t index;
+    std::uint64_t rng_state;
+    std::uint32_t local_pops = 0;
+    ChaseLevDeque<handle_type> deque{};
+    std::thread thread{};
+
+    worker(WorkStealingScheduler *s, std::size_t i)
+        : owner{s}, index{i}, rng_state{0x9e3779b97f4a7c15ull * (i + 1)} {}
+
+    std::size_t random(std::size_t bound) noexcept {
+      rng_state ^= rng_state << 13;
+      rng_state ^= rng_state >> 7;
+      rng_state ^= rng_state << 17;
+      return static_cast<std::size_t>(rng_state % bound);
+    }
+  };
+
+  static inline thread_local worker *tl_worker = nullptr;
+
+  // A worker looks at the injection queue first once in this many turns,
+  // so that a busy deque cannot starve it.
+  static constexpr std::uint32_t injection_check_interval = 61;
+
+  std::vector<std::unique_ptr<worker>> m_workers;
+  InjectionQueue<handle_type> m_injection{};
+  alignas(64) std::atomic<std::uint32_t> m_wake_epoch{0};
+  alignas(64) std::atomic<std::uint32_t> m_sleepers{0};
+  alignas(64) std::atomic<std::int64_t> m_pending{0};
+  std::atomic<bool> m_stop{false};
+
+  worker *current_worker() const noexcept {
+    return tl_worker && tl_worker->owner == this ? tl_worker : nullptr;
+  }
+
+  handle_type take_injected() {
+    if (auto handle = m_injection.try_pop())
+      return *handle;
+    return nullptr;
+  }
+
+  handle_type steal_from_others(worker &self) {
+    auto n = m_workers.size();
+    if (n < 2)
+      return nullptr;
+    auto start = self.random(n);
+    std::size_t attempts = 0;
+    for (std::size_t k = 0; k != n; ++k) {
+      auto &victim = *m_workers[(start + k) % n];
+      if (&victim == &self)
+        continue;
+      ++attempts;
+      if (auto handle = victim.deque.steal()) {
+        detail::metrics_steal(attempts, true);
+        return *handle;
+      }
+    }
+    detail::metrics_steal(attempts, false);
+    return nullptr;
+  }
+
+  handle_type find_work(worker &self) {
+    if (++self.local_pops == injection_check_interval) {
+      self.local_pops = 0;
+      if (auto handle = take_injected())
+        return handle;
+    }
+    if (auto handle = self.deque.pop())
+      return *handle;
+    if (auto handle = take_injected())
+      return handle;
+    return steal_from_others(self);
+  }
+
+  void wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_seq_cst) != 0) {
+      m_wake_epoch.fetch_add(1, std::memory_order_release);
+      m_wake_epoch.notify_one();
+    }
+  }
+
+  void run_task(handle_type handle) {
+    if (!handle.done()) {
+      [[maybe_unused]] detail::metrics_resume_scope timing{[] {
+        return tl_worker ? tl_worker->deque.size() : 0;
+      }};
+      handle.resume();
+    }
+    if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      m_pending.notify_all();
+  }
+
+  void worker_loop(worker &self) {
+    tl_worker = &self;
+    while (true) {
+      if (auto handle = find_work(self)) {
+        run_task(handle);
+        continue;
+      }
+      auto epoch = m_wake_epoch.load(std::memory_order_acquire);
+      m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+      if (auto handle = find_work(self)) {
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        run_task(handle);
+        continue;
+      }
+      if (m_stop.load(std::memory_order_acquire)) {
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        break;
+      }
+      {
+        [[maybe_unused]] detail::metrics_idle_scope idle;
+        m_wake_epoch.wait(epoch, std::memory_order_acquire);
+      }
+      m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+    tl_worker = nullptr;
+  }
+
+ public:
+  explicit WorkStealingScheduler(
+      std::size_t workers = std::thread::hardware_concurrency()) {
+    if (workers == 0)
+      workers = 1;
+    m_workers.reserve(workers);
+    for (std::size_t i = 0; i != workers; ++i)
+      m_workers.push_back(std::make_unique<worker>(this, i));
+    for (auto &w : m_workers)
+      w->thread =
+          std::thread{[this, self = w.get()] { worker_loop(*self); }};
+  }
+
+  WorkStealingScheduler(const WorkStealingScheduler &) = delete;
+  WorkStealingScheduler &operator=(const WorkStealingScheduler &) = delete;
+
+  // Tasks still queued at this point are not resumed; call wait_idle()
+  // first.
+  ~WorkStealingScheduler() {
+    m_stop.store(true, std::memory_order_release);
+    m_wake_epoch.fetch_add(1, std::memory_order_release);
+    m_wake_epoch.notify_all();
+    for (auto &w : m_workers)
+      w->thread.join();
+  }
+
+  std::size_t worker_count() const noexcept {
+    return m_workers.size();
+  }
+
+  // Tasks waiting in the calling worker's own deque; 0 outside the pool. An
+  // empty deque means idle workers have nothing to steal from this one.
+  std::size_t local_queue_size() const noexcept {
+    auto self = current_worker();
+    return self ? static_cast<std::size_t>(self->deque.size()) : 0;
+  }
+
+  void post(handle_type handle) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    if (auto self = current_worker())
+      self->deque.push(handle);
+    else
+      m_injection.push(handle);
+    wake_one();
+  }
+
+  // Queues `handle` behind everything already waiting.
+  void requeue(handle_type handle) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_injection.push(handle);
+    wake_one();
+  }
+
+  void spawn(Task<> task) {
+    post(std::move(task).release());
+  }
+
+  auto suspend() {
+    struct awaiter : std::suspend_always {
+      WorkStealingScheduler &scheduler;
+      constexpr awaiter(WorkStealingScheduler &s) noexcept : scheduler{s} {}
+      void await_suspend(std::coroutine_handle<> handle) {
+        scheduler.requeue(handle);
+      }
+    };
+    return awaiter{*this};
+  }
+
+  // Like suspend(), but on a worker the task goes to the bottom of its
+  // deque, where idle workers steal it from. The worker itself picks it up
+  // again next, so this hands work off rather than yielding.
+  auto fork() {
+    struct awaiter : std::suspend_always {
+      WorkStealingScheduler &scheduler;
+      constexpr awaiter(WorkStealingScheduler &s) noexcept : scheduler{s} {}
+      void await_suspend(std::coroutine_handle<> handle) {
+        scheduler.post(handle);
+      }
+    };
+    return awaiter{*this};
+  }
+
+  // Blocks until every posted task has run and nothing is queued.
+  void wait_idle() {
+    auto pending = m_pending.load(std::memory_order_acquire);
+    while (pending != 0) {
+      m_pending.wait(pending, std::memory_order_acquire);
+      pending = m_pending.load(std::memory_order_acquire);
+    }
+  }
+};
+
+} // namespace gkxx
+
+#endif // GKXX_CORO_WORK_STEALING_SCHEDULER_HPP
@@ -2,11 +2,20 @@
 #define GKXX_FUNCTION_HPP
 
 #include <concepts>
+#include <cstddef>
 #include <exception>
-#include <memory>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
 
 #include "invoke.hpp"
-#include "memory/unique_ptr.hpp"
+
+// Targets of up to this many bytes are stored inside the function object
+// rather than on the heap.
+#ifndef GKXX_FUNCTION_SMALL_SIZE
+#define GKXX_FUNCTION_SMALL_SIZE (3 * sizeof(void *))
+#endif
 
 namespace gkxx {
 
@@ -39,7 +48,9 @@ namespace detail {
 
 } // namespace detail
 
-// TODO: small object optimization
+// Small targets that are nothrow move constructible, such as function
+// pointers and lambdas capturing a few pointers, are stored in place; the
+// others are allocated.
 template <typename R, typename... Args>
 class function<R(Args...)> {
  public:
@@ -54,17 +65,22 @@ class function<R(Args...)> {
   // (3)
   function(const function &other) : pimpl{} {
     if (other.pimpl)
-      pimpl = other.pimpl->clone();
+      pimpl = other.pimpl->clone(buffer);
   }
 
   // (4)
-  function(function &&) noexcept = default;
+  function(function &&other) noexcept : pimpl{} {
+    take(other);
+  }
 
   // (5)
   template <typename Fn>
     requires(std::is_invocable_r_v<R, std::decay_t<Fn> &, Args...> &&
              !std::is_same_v<std::decay_t<Fn>, function>)
-  function(Fn &&fn) : pimpl{} { // TODO: noexcept-ness
+  function(Fn &&fn) noexcept(
+      stored_in_place<std::decay_t<Fn>> &&
+      std::is_nothrow_constructible_v<std::decay_t<Fn>, Fn>)
+      : pimpl{} {
     using target = std::decay_t<Fn>;
 
     static_assert(std::is_copy_constructible_v<target>,
@@ -73,8 +89,13 @@ class function<R(Args...)> {
                   "function target type must be constructible from the "
                   "constructor argument");
 
-    if (detail::not_empty_function(fn))
-      pimpl = make_unique<wrapper<target>>(std::forward<Fn>(fn));
+    if (detail::not_empty_function(fn)) {
+      if constexpr (stored_in_place<target>)
+        pimpl = ::new (static_cast<void *>(buffer))
+            wrapper<target>(std::forward<Fn>(fn));
+      else
+        pimpl = new wrapper<target>(std::forward<Fn>(fn));
+    }
   }
 
   // (1), (2)
@@ -85,7 +106,7 @@ class function<R(Args...)> {
 
   // (3)
   function &operator=(std::nullptr_t) noexcept {
-    pimpl.reset();
+    reset();
     return *this;
   }
 
@@ -104,14 +125,21 @@ class function<R(Args...)> {
     return *this;
   }
 
-  ~function() = default;
+  ~function() {
+    reset();
+  }
 
   void swap(function &other) noexcept {
-    pimpl.swap(other.pimpl);
+    if (this == &other)
+      return;
+    function tmp;
+    tmp.take(other);
+    other.take(*this);
+    take(tmp);
   }
 
   explicit operator bool() const noexcept {
-    return static_cast<bool>(pimpl);
+    return pimpl != nullptr;
   }
 
   R operator()(Args... args) const {
@@ -137,25 +165,64 @@ class function<R(Args...)> {
 
   template <typename T>
   T *target() noexcept {
-    return const_cast<T *>(static_cast<const function *>(this)->target());
+    return const_cast<T *>(static_cast<const function *>(this)->target<T>());
   }
 
  private:
   struct wrapper_base {
     virtual ~wrapper_base() = default;
-    virtual auto clone() const -> unique_ptr<wrapper_base> = 0;
+    // Copies the target into `buf` if it is stored in place, or onto the
+    // heap otherwise.
+    virtual auto clone(void *buf) const -> wrapper_base * = 0;
+    // Moves an in-place target into `buf`; a heap one just changes owner.
+    virtual auto relocate(void *buf) noexcept -> wrapper_base * = 0;
+    virtual void destroy() noexcept = 0;
     virtual auto invoke(Args... args) const -> R = 0;
     virtual auto get_typeid() const -> const std::type_info & = 0;
     virtual auto get_ptr() -> void * = 0;
   };
+
+  // The wrapper's vtable pointer takes a word of the buffer on top of the
+  // target.
+  static constexpr std::size_t buffer_size =
+      GKXX_FUNCTION_SMALL_SIZE + sizeof(void *);
+  static constexpr std::size_t buffer_align = alignof(std::max_align_t);
+
+  template <typename F>
+  struct wrapper;
+
+  template <typename F>
+  static constexpr bool stored_in_place =
+      sizeof(wrapper<F>) <= buffer_size &&
+      alignof(wrapper<F>) <= buffer_align &&
+      std::is_nothrow_move_constructible_v<F>;
+
   template <typename F>
     requires std::same_as<F, std::decay_t<F>>
-  struct wrapper final : public wrapper_base {
+  struct wrapper<F> final : public wrapper_base {
     F func;
     template <typename Fn>
     wrapper(Fn &&fn) : func(std::forward<Fn>(fn)) {}
-    unique_ptr<wrapper_base> clone() const final {
-      return make_unique<wrapper<F>>(func);
+    wrapper_base *clone(void *buf) const final {
+      if constexpr (stored_in_place<F>)
+        return ::new (buf) wrapper(func);
+      else
+        return new wrapper(func);
+    }
+    wrapper_base *relocate(void *buf) noexcept final {
+      if constexpr (stored_in_place<F>) {
+        auto ret = ::new (buf) wrapper(std::move(func));
+        this->~wrapper();
+        return ret;
+      } else {
+        return this;
+      }
+    }
+    void destroy() noexcept final {
+      if constexpr (stored_in_place<F>)
+        this->~wrapper();
+      else
+        delete this;
     }
     R invoke(Args... args) const final {
       return ::gkxx::invoke(func, std::forward<Args>(args)...);
@@ -168,7 +235,24 @@ class function<R(Args...)> {
     }
     ~wrapper() = default;
   };
-  unique_ptr<wrapper_base> pimpl;
+
+  // Moves the target of `other` into this empty function.
+  void take(function &other) noexcept {
+    if (other.pimpl) {
+      pimpl = other.pimpl->relocate(buffer);
+      other.pimpl = nullptr;
+    }
+  }
+
+  void reset() noexcept {
+    if (pimpl) {
+      pimpl->destroy();
+      pimpl = nullptr;
+    }
+  }
+
+  wrapper_base *pimpl;
+  alignas(buffer_align) std::byte buffer[buffer_size];
 };
 
 template <typename R, typename... Args>
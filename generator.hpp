@@ -3,20 +3,36 @@
 
 #include <concepts>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
 #include <iterator>
 #include <optional>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace gkxx {
 
+namespace detail {
+
+  struct generator_access;
+
+} // namespace detail
+
+// `co_yield size_hint{n};` before the first value tells to() and collect()
+// how many values will follow. It does not suspend the coroutine.
+struct size_hint {
+  std::size_t value;
+};
+
 template <typename Yielded>
 class Generator {
  public:
   class promise_type;
 
  private:
+  friend struct detail::generator_access;
+
   using handle_type = std::coroutine_handle<promise_type>;
   handle_type m_coro_handle;
 
@@ -60,6 +76,7 @@ class Generator<Yielded>::promise_type {
  private:
   std::optional<Yielded> m_value{};
   std::exception_ptr m_exception;
+  std::size_t m_size_hint{};
 
  public:
   Generator<Yielded> get_return_object() noexcept {
@@ -85,12 +102,30 @@ class Generator<Yielded>::promise_type {
     return {};
   }
 
+  std::suspend_never yield_value(size_hint hint) noexcept {
+    m_size_hint = hint.value;
+    return {};
+  }
+
   void return_void() const noexcept {}
 
   [[nodiscard]] Yielded const &get_value() const noexcept {
     return *m_value;
   }
 
+  [[nodiscard]] Yielded &&take_value() noexcept {
+    return std::move(*m_value);
+  }
+
+  [[nodiscard]] std::size_t get_size_hint() const noexcept {
+    return m_size_hint;
+  }
+
+  void rethrow_if_exception() const {
+    if (m_exception)
+      std::rethrow_exception(m_exception);
+  }
+
   [[nodiscard]] bool has_value() const noexcept {
     return static_cast<bool>(m_value);
   }
@@ -127,6 +162,8 @@ class Generator<Yielded>::iterator {
 
   iterator &operator++() {
     m_coro_handle.resume();
+    if (m_coro_handle.done())
+      m_coro_handle.promise().rethrow_if_exception();
     return *this;
   }
 
@@ -134,11 +171,54 @@ class Generator<Yielded>::iterator {
     ++*this;
   }
 
-  reference operator*() noexcept {
+  reference operator*() const noexcept {
     return m_coro_handle.promise().get_value();
   }
 };
 
+namespace detail {
+
+  struct generator_access {
+    template <typename Yielded>
+    static auto handle(Generator<Yielded> &gen) noexcept {
+      return gen.m_coro_handle;
+    }
+  };
+
+} // namespace detail
+
+// Drains a Generator into a container, reserving the size hint up front
+// and moving every value out of the promise.
+template <typename Container, typename Yielded>
+Container to(Generator<Yielded> gen) {
+  Container result;
+  auto handle = detail::generator_access::handle(gen);
+  auto &promise = handle.promise();
+  handle.resume();
+  if constexpr (requires(std::size_t n) { result.reserve(n); }) {
+    if (auto hint = promise.get_size_hint())
+      result.reserve(hint);
+  }
+  for (; !handle.done(); handle.resume()) {
+    if constexpr (requires { result.emplace_back(promise.take_value()); })
+      result.emplace_back(promise.take_value());
+    else
+      result.insert(result.end(), promise.take_value());
+  }
+  promise.rethrow_if_exception();
+  return result;
+}
+
+template <template <typename...> typename Container, typename Yielded>
+Container<Yielded> to(Generator<Yielded> gen) {
+  return to<Container<Yielded>>(std::move(gen));
+}
+
+template <typename Yielded>
+std::vector<Yielded> collect(Generator<Yielded> gen) {
+  return to<std::vector<Yielded>>(std::move(gen));
+}
+
 } // namespace gkxx
 
 #endif // GKXX_EXERCISE_GENERATOR_HPP
\ No newline at end of file
@@ -0,0 +1,230 @@
+#ifndef GKXX_PREFETCH_HPP
+#define GKXX_PREFETCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "generator.hpp"
+
+namespace gkxx {
+
+namespace detail {
+
+  inline constexpr std::size_t cache_line_size = 64;
+
+  inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  // Single-producer/single-consumer ring buffer. The high bit of `m_tail`
+  // tells the consumer that the producer has finished, the high bit of
+  // `m_head` tells the producer that the consumer has gone away. Both
+  // sides block on the counter of the other side through atomic wait.
+  template <typename Type>
+  class spsc_ring {
+   public:
+    static constexpr std::size_t flag_bit = std::size_t{1}
+                                            << (sizeof(std::size_t) * 8 - 1);
+
+    explicit spsc_ring(std::size_t capacity)
+        : m_capacity{capacity ? capacity : 1},
+          m_slots{std::make_unique<slot[]>(m_capacity)} {}
+
+    spsc_ring(const spsc_ring &) = delete;
+    spsc_ring &operator=(const spsc_ring &) = delete;
+
+    ~spsc_ring() {
+      auto head = m_head.load(std::memory_order_relaxed) & ~flag_bit;
+      auto tail = m_tail.load(std::memory_order_relaxed) & ~flag_bit;
+      for (; head != tail; ++head)
+        std::destroy_at(ptr(head));
+    }
+
+    // producer side
+    template <typename... Args>
+    bool push(Args &&...args) {
+      auto tail = m_tail.load(std::memory_order_relaxed);
+      auto head = wait_while(m_head, [&](std::size_t h) {
+        return !(h & flag_bit) && tail - h == m_capacity;
+      });
+      if (head & flag_bit)
+        return false;
+      ::new (static_cast<void *>(ptr(tail))) Type(std::forward<Args>(args)...);
+      m_tail.store(tail + 1, std::memory_order_release);
+      m_tail.notify_one();
+      return true;
+    }
+
+    void close() noexcept {
+      m_tail.fetch_or(flag_bit, std::memory_order_release);
+      m_tail.notify_one();
+    }
+
+    // consumer side
+    Type *front() noexcept {
+      auto head = m_head.load(std::memory_order_relaxed);
+      auto tail = wait_while(m_tail, [&](std::size_t t) {
+        return !(t & flag_bit) && t == head;
+      });
+      return (tail & ~flag_bit) == head ? nullptr : ptr(head);
+    }
+
+    void pop() noexcept {
+      auto head = m_head.load(std::memory_order_relaxed);
+      std::destroy_at(ptr(head));
+      m_head.store(head + 1, std::memory_order_release);
+      m_head.notify_one();
+    }
+
+    void cancel() noexcept {
+      m_head.fetch_or(flag_bit, std::memory_order_release);
+      m_head.notify_one();
+    }
+
+   private:
+    struct slot {
+      alignas(Type) unsigned char storage[sizeof(Type)];
+    };
+
+    Type *ptr(std::size_t index) noexcept {
+      return std::launder(
+          reinterpret_cast<Type *>(m_slots[index % m_capacity].storage));
+    }
+
+    template <typename Pred>
+    static std::size_t wait_while(std::atomic<std::size_t> &counter,
+                                  Pred pred) noexcept {
+      auto value = counter.load(std::memory_order_acquire);
+      for (int spin = 0; pred(value) && spin != 128; ++spin) {
+        cpu_relax();
+        value = counter.load(std::memory_order_acquire);
+      }
+      while (pred(value)) {
+        counter.wait(value, std::memory_order_acquire);
+        value = counter.load(std::memory_order_acquire);
+      }
+      return value;
+    }
+
+    const std::size_t m_capacity;
+    std::unique_ptr<slot[]> m_slots;
+    alignas(cache_line_size) std::atomic<std::size_t> m_head{0};
+    alignas(cache_line_size) std::atomic<std::size_t> m_tail{0};
+  };
+
+} // namespace detail
+
+// Runs the body of a Generator on a worker thread, keeping up to `depth`
+// values ready ahead of the consumer.
+template <typename Yielded>
+class Prefetched {
+  struct shared_state {
+    Generator<Yielded> generator;
+    detail::spsc_ring<Yielded> ring;
+    std::exception_ptr exception{};
+
+    shared_state(Generator<Yielded> gen, std::size_t depth)
+        : generator{std::move(gen)}, ring{depth} {}
+
+    void produce() noexcept {
+      auto handle = detail::generator_access::handle(generator);
+      try {
+        while (true) {
+          handle.resume();
+          if (handle.done())
+            break;
+          if (!ring.push(handle.promise().take_value()))
+            return;
+        }
+        handle.promise().rethrow_if_exception();
+      } catch (...) {
+        exception = std::current_exception();
+      }
+      ring.close();
+    }
+  };
+
+  std::unique_ptr<shared_state> m_state;
+  std::jthread m_worker;
+
+ public:
+  Prefetched(Generator<Yielded> gen, std::size_t depth)
+      : m_state{std::make_unique<shared_state>(std::move(gen), depth)},
+        m_worker{[state = m_state.get()] { state->produce(); }} {}
+
+  Prefetched(Prefetched &&) noexcept = default;
+  Prefetched &operator=(Prefetched &&) = delete;
+
+  ~Prefetched() {
+    if (m_state)
+      m_state->ring.cancel();
+  }
+
+  class iterator {
+    shared_state *m_state;
+    Yielded *m_current;
+
+    void fetch() {
+      m_current = m_state->ring.front();
+      if (!m_current && m_state->exception)
+        std::rethrow_exception(m_state->exception);
+    }
+
+   public:
+    using value_type = Yielded;
+    using reference = Yielded const &;
+    using pointer = Yielded const *;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::input_iterator_tag;
+
+    explicit iterator(shared_state *state) : m_state{state}, m_current{} {
+      fetch();
+    }
+
+    bool operator==(std::default_sentinel_t) const noexcept {
+      return m_current == nullptr;
+    }
+
+    iterator &operator++() {
+      m_state->ring.pop();
+      fetch();
+      return *this;
+    }
+
+    void operator++(int) {
+      ++*this;
+    }
+
+    reference operator*() const noexcept {
+      return *m_current;
+    }
+  };
+
+  iterator begin() {
+    return iterator{m_state.get()};
+  }
+  std::default_sentinel_t end() const noexcept {
+    return {};
+  }
+};
+
+template <typename Yielded>
+inline Prefetched<Yielded> prefetch(Generator<Yielded> gen,
+                                    std::size_t depth = 16) {
+  return {std::move(gen), depth};
+}
+
+} // namespace gkxx
+
+#endif // GKXX_PREFETCH_HPP
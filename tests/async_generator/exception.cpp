@@ -0,0 +1,32 @@
+#include "../../coro/async_generator.hpp"
+#include "../../coro/scheduler.hpp"
+#include <iostream>
+#include <stdexcept>
+
+gkxx::AsyncGenerator<int> failing(gkxx::Scheduler &scheduler) {
+  co_yield 1;
+  co_await scheduler.suspend();
+  throw std::runtime_error{"producer failed"};
+}
+
+int result = 1;
+
+gkxx::Task<> consumer(gkxx::Scheduler &scheduler) {
+  auto gen = failing(scheduler);
+  auto it = gen.begin();
+  try {
+    while (co_await it.next())
+      std::cout << *it << '\n';
+  } catch (const std::runtime_error &e) {
+    std::cout << "caught: " << e.what() << '\n';
+    result = 0;
+  }
+}
+
+int main() {
+  gkxx::Scheduler scheduler{};
+  scheduler.spawn(consumer(scheduler));
+  while (scheduler.schedule())
+    ;
+  return result;
+}
@@ -0,0 +1,40 @@
+#include "../../coro/async_generator.hpp"
+#include "../../coro/scheduler.hpp"
+#include <iostream>
+#include <string>
+
+gkxx::AsyncGenerator<int> numbers(gkxx::Scheduler &scheduler, int n) {
+  for (int i = 0; i != n; ++i) {
+    co_await scheduler.suspend();
+    co_yield i;
+  }
+}
+
+gkxx::AsyncGenerator<std::string> labelled(gkxx::AsyncGenerator<int> source) {
+  auto it = source.begin();
+  while (co_await it.next())
+    co_yield "item " + std::to_string(*it);
+}
+
+gkxx::Task<> consumer(gkxx::AsyncGenerator<std::string> source) {
+  auto it = source.begin();
+  while (co_await it.next())
+    std::cout << "consumer got " << *it << '\n';
+  std::cout << "consumer done\n";
+}
+
+gkxx::Task<> ticker(gkxx::Scheduler &scheduler, int n) {
+  for (int i = 0; i != n; ++i) {
+    std::cout << "tick " << i << '\n';
+    co_await scheduler.suspend();
+  }
+}
+
+int main() {
+  gkxx::Scheduler scheduler{};
+  scheduler.spawn(consumer(labelled(numbers(scheduler, 4))));
+  scheduler.spawn(ticker(scheduler, 4));
+  while (scheduler.schedule())
+    ;
+  return 0;
+}
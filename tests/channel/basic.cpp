@@ -0,0 +1,176 @@
+#include "../../coro/channel.hpp"
+#include "../../coro/scheduler.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+std::atomic<std::size_t> allocations{0};
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+using IntChannel = gkxx::Channel<int>;
+
+gkxx::Task<> produce(IntChannel &out, int count) {
+  for (int i = 1; i <= count; ++i) {
+    bool sent = co_await out.send(i);
+    assert(sent);
+  }
+  out.close();
+}
+
+gkxx::Task<> square(IntChannel &in, gkxx::Channel<std::string> &out) {
+  while (auto x = co_await in.recv()) {
+    bool sent = co_await out.send(std::to_string(*x * *x));
+    assert(sent);
+  }
+  out.close();
+}
+
+gkxx::Task<> consume(gkxx::Channel<std::string> &in, long &sum) {
+  while (auto s = co_await in.recv())
+    sum += std::stol(*s);
+}
+
+void pipeline(std::size_t capacity) {
+  gkxx::Scheduler scheduler{};
+  IntChannel numbers{scheduler, capacity};
+  gkxx::Channel<std::string> squares{scheduler, capacity};
+  long sum = 0;
+  scheduler.spawn(consume(squares, sum));
+  scheduler.spawn(square(numbers, squares));
+  scheduler.spawn(produce(numbers, 1000));
+  while (scheduler.schedule())
+    ;
+  assert(sum == 333833500);
+  std::cout << "pipeline with capacity " << capacity << ": OK\n";
+}
+
+// Once everything is running, sending and receiving allocate nothing; only
+// the scheduler's std::queue still allocates a chunk now and then.
+gkxx::Task<> ping(IntChannel &out, IntChannel &in, int rounds,
+                  std::size_t &allocated) {
+  co_await out.send(0);
+  co_await in.recv();
+  auto before = allocations.load();
+  for (int i = 0; i != rounds; ++i) {
+    co_await out.send(i);
+    auto x = co_await in.recv();
+    assert(x && *x == i + 1);
+  }
+  allocated = allocations.load() - before;
+  out.close();
+}
+
+gkxx::Task<> pong(IntChannel &in, IntChannel &out) {
+  while (auto x = co_await in.recv())
+    co_await out.send(*x + 1);
+}
+
+void no_allocation() {
+  gkxx::Scheduler scheduler{};
+  IntChannel there{scheduler}, back{scheduler};
+  std::size_t allocated = 1;
+  scheduler.spawn(ping(there, back, 10000, allocated));
+  scheduler.spawn(pong(there, back));
+  while (scheduler.schedule())
+    ;
+  assert(allocated < 10000 / 16);
+  std::cout << "no allocation per message: OK\n";
+}
+
+gkxx::Task<> blocked_sender(IntChannel &ch, int &result) {
+  co_await ch.send(1);
+  result = co_await ch.send(2) ? 1 : 0;
+}
+
+gkxx::Task<> blocked_receiver(IntChannel &ch, int &result) {
+  auto x = co_await ch.recv();
+  result = x ? *x : -1;
+}
+
+void close() {
+  gkxx::Scheduler scheduler{};
+  IntChannel full{scheduler, 1}, empty{scheduler, 1};
+  int sent = -1, received = 0;
+  scheduler.spawn(blocked_sender(full, sent));
+  scheduler.spawn(blocked_receiver(empty, received));
+  scheduler.schedule();
+  scheduler.schedule();
+  full.close();
+  empty.close();
+  while (scheduler.schedule())
+    ;
+  assert(sent == 0 && received == -1);
+
+  // Buffered values survive the close.
+  auto drain = [](IntChannel &ch, std::vector<int> &out) -> gkxx::Task<> {
+    while (auto x = co_await ch.recv())
+      out.push_back(*x);
+  };
+  std::vector<int> values;
+  scheduler.spawn(drain(full, values));
+  while (scheduler.schedule())
+    ;
+  assert(values == std::vector<int>{1});
+  std::cout << "close: OK\n";
+}
+
+using PoolChannel = gkxx::Channel<int, gkxx::WorkStealingScheduler>;
+
+gkxx::Task<> pool_produce(PoolChannel &out, int first, int count,
+                          std::atomic<int> &producers) {
+  for (int i = first; i != first + count; ++i)
+    co_await out.send(i);
+  if (--producers == 0)
+    out.close();
+}
+
+gkxx::Task<> pool_consume(PoolChannel &in, std::atomic<long> &sum) {
+  while (auto x = co_await in.recv())
+    sum += *x;
+}
+
+void many_to_many() {
+  constexpr int producers = 8, consumers = 8, per_producer = 10000;
+  std::atomic<long> sum{0};
+  {
+    gkxx::WorkStealingScheduler pool{4};
+    PoolChannel ch{pool, 16};
+    std::atomic<int> remaining{producers};
+    for (int c = 0; c != consumers; ++c)
+      pool.spawn(pool_consume(ch, sum));
+    for (int p = 0; p != producers; ++p)
+      pool.spawn(pool_produce(ch, p * per_producer, per_producer, remaining));
+    pool.wait_idle();
+  }
+  long n = producers * per_producer;
+  assert(sum.load() == n * (n - 1) / 2);
+  std::cout << "8 producers, 8 consumers on 4 workers: OK\n";
+}
+
+int main() {
+  pipeline(0);
+  pipeline(1);
+  pipeline(64);
+  no_allocation();
+  close();
+  many_to_many();
+  return 0;
+}
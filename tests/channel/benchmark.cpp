@@ -0,0 +1,151 @@
+// Fan-out on one Scheduler: one producer feeding `consumers` tasks
+// round-robin, each through its own bounded queue. Channel parks the idle
+// consumers; the baseline is a plain std::queue per consumer polled with
+// suspend(), which is what tasks had to do before, and which keeps
+// rescheduling every idle consumer. The first part runs flat out; in the
+// second the producer sleeps between messages and the cost that counts is
+// the CPU time burnt while waiting.
+//
+// usage: benchmark [messages] [capacity]
+#include "../../coro/channel.hpp"
+#include "../../coro/scheduler.hpp"
+#include "../../tictoc.hpp"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <queue>
+#include <string>
+
+namespace {
+
+long sum = 0;
+long polls = 0;
+
+gkxx::Task<> produce(gkxx::Scheduler &scheduler,
+                     std::deque<gkxx::Channel<long>> &out, long count,
+                     std::chrono::microseconds pause) {
+  for (long i = 0; i != count; ++i) {
+    if (pause.count() != 0)
+      co_await scheduler.sleep_for(pause);
+    co_await out[static_cast<std::size_t>(i) % out.size()].send(i);
+  }
+  for (auto &ch : out)
+    ch.close();
+}
+
+gkxx::Task<> consume(gkxx::Channel<long> &in) {
+  while (auto x = co_await in.recv())
+    sum += *x;
+}
+
+struct PolledQueue {
+  std::queue<long> values;
+  std::size_t capacity;
+  bool closed = false;
+};
+
+gkxx::Task<> produce_polling(gkxx::Scheduler &scheduler,
+                             std::deque<PolledQueue> &out, long count,
+                             std::chrono::microseconds pause) {
+  for (long i = 0; i != count; ++i) {
+    if (pause.count() != 0)
+      co_await scheduler.sleep_for(pause);
+    auto &q = out[static_cast<std::size_t>(i) % out.size()];
+    while (q.values.size() >= q.capacity) {
+      ++polls;
+      co_await scheduler.suspend();
+    }
+    q.values.push(i);
+  }
+  for (auto &q : out)
+    q.closed = true;
+}
+
+gkxx::Task<> consume_polling(gkxx::Scheduler &scheduler, PolledQueue &in) {
+  while (true) {
+    if (!in.values.empty()) {
+      sum += in.values.front();
+      in.values.pop();
+    } else if (in.closed) {
+      break;
+    } else {
+      ++polls;
+      co_await scheduler.suspend();
+    }
+  }
+}
+
+struct Run {
+  double seconds, cpu_seconds;
+};
+
+Run run_channel(std::size_t consumers, std::size_t capacity, long messages,
+                std::chrono::microseconds pause) {
+  gkxx::Scheduler scheduler{};
+  std::deque<gkxx::Channel<long>> channels;
+  for (std::size_t i = 0; i != consumers; ++i)
+    channels.emplace_back(scheduler, capacity);
+  sum = polls = 0;
+  auto start = gkxx::tic();
+  auto cpu_start = std::clock();
+  for (auto &ch : channels)
+    scheduler.spawn(consume(ch));
+  scheduler.spawn(produce(scheduler, channels, messages, pause));
+  while (scheduler.schedule())
+    ;
+  return {std::chrono::duration<double>(gkxx::toc(start)).count(),
+          static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC};
+}
+
+Run run_polling(std::size_t consumers, std::size_t capacity, long messages,
+                std::chrono::microseconds pause) {
+  gkxx::Scheduler scheduler{};
+  std::deque<PolledQueue> queues;
+  for (std::size_t i = 0; i != consumers; ++i)
+    queues.push_back({{}, capacity});
+  sum = polls = 0;
+  auto start = gkxx::tic();
+  auto cpu_start = std::clock();
+  for (auto &q : queues)
+    scheduler.spawn(consume_polling(scheduler, q));
+  scheduler.spawn(produce_polling(scheduler, queues, messages, pause));
+  while (scheduler.schedule())
+    ;
+  return {std::chrono::duration<double>(gkxx::toc(start)).count(),
+          static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC};
+}
+
+void report(const char *name, std::size_t consumers, long messages,
+            const Run &run) {
+  std::printf("  %-18s %4zu consumers   %10.0f msg/s   %5.0f%% CPU   "
+              "%8.3f polls/msg\n",
+              name, consumers, static_cast<double>(messages) / run.seconds,
+              100 * run.cpu_seconds / run.seconds,
+              static_cast<double>(polls) / static_cast<double>(messages));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  long messages = argc > 1 ? std::stol(argv[1]) : 2000000;
+  std::size_t capacity = argc > 2 ? std::stoul(argv[2]) : 16;
+  std::printf("%ld messages, capacity %zu:\n", messages, capacity);
+  for (std::size_t consumers : {1, 16, 256}) {
+    report("Channel", consumers, messages,
+           run_channel(consumers, capacity, messages, {}));
+    report("queue + suspend()", consumers, messages,
+           run_polling(consumers, capacity, messages, {}));
+  }
+  using namespace std::chrono_literals;
+  constexpr long slow_messages = 200;
+  std::printf("%ld messages 1ms apart, capacity %zu:\n", slow_messages,
+              capacity);
+  for (std::size_t consumers : {1, 16, 256}) {
+    report("Channel", consumers, slow_messages,
+           run_channel(consumers, capacity, slow_messages, 1ms));
+    report("queue + suspend()", consumers, slow_messages,
+           run_polling(consumers, capacity, slow_messages, 1ms));
+  }
+  return sum == 0;
+}
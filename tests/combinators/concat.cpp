@@ -0,0 +1,23 @@
+#include "../../combinators.hpp"
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+gkxx::Generator<std::string> words() {
+  co_yield "hello";
+  co_yield "generator";
+}
+
+int main() {
+  std::vector<std::string> more{"and", "vector"};
+  for (auto const &s : gkxx::concat(words(), std::vector<std::string>{}, more))
+    std::cout << s << ' ';
+  std::cout << '\n';
+
+  std::vector<std::array<int, 2>> pairs{{1, 2}, {3, 4}, {5, 6}};
+  for (auto x : gkxx::concat(pairs))
+    std::cout << x << ' ';
+  std::cout << '\n';
+  return 0;
+}
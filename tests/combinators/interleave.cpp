@@ -0,0 +1,21 @@
+#include "../../combinators.hpp"
+#include <iostream>
+#include <vector>
+
+gkxx::Generator<int> from(std::vector<int> const &v) {
+  for (auto x : v)
+    co_yield x;
+}
+
+int main() {
+  std::vector a{1, 3, 5, 7, 9, 11}, b{2, 4, 6, 8};
+  for (auto x : gkxx::interleave(from(a), b))
+    std::cout << x << ' ';
+  std::cout << '\n';
+
+  std::vector<std::vector<int>> rows{{1, 4, 7}, {}, {2, 5}, {3, 6, 8, 9}};
+  for (auto x : gkxx::interleave(rows))
+    std::cout << x << ' ';
+  std::cout << '\n';
+  return 0;
+}
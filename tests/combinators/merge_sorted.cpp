@@ -0,0 +1,37 @@
+#include "../../combinators.hpp"
+#include <functional>
+#include <iostream>
+#include <list>
+#include <vector>
+
+gkxx::Generator<int> multiples(int step, int count) {
+  for (int i = 1; i <= count; ++i)
+    co_yield i * step;
+}
+
+int main() {
+  std::vector v{1, 4, 9, 16};
+  std::list l{0, 10, 20};
+  for (auto x : gkxx::merge_sorted(multiples(2, 5), multiples(3, 4), v, l))
+    std::cout << x << ' ';
+  std::cout << '\n';
+
+  std::vector<gkxx::Generator<int>> streams;
+  for (int step = 1; step <= 32; ++step)
+    streams.push_back(multiples(step, 3));
+  int previous = 0, count = 0;
+  for (auto x : gkxx::merge_sorted(streams)) {
+    if (x < previous)
+      return 1;
+    previous = x;
+    ++count;
+  }
+  std::cout << count << " values merged from " << streams.size()
+            << " streams\n";
+
+  for (auto x : gkxx::merge_sorted_by(std::greater<>{}, std::vector{9, 5, 1},
+                                      std::vector{8, 2}))
+    std::cout << x << ' ';
+  std::cout << '\n';
+  return count == 96 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+#include "../../coro/channel.hpp"
+#include "../../coro/fiber.hpp"
+#include "../../coro/scheduler.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+gkxx::Task<> task_steps(gkxx::Scheduler &scheduler, std::string &trace) {
+  for (int i = 0; i != 3; ++i) {
+    trace += 't';
+    co_await scheduler.suspend();
+  }
+}
+
+// Fibers share the FIFO run queue with stackless tasks.
+void interleaving() {
+  gkxx::Scheduler scheduler{};
+  std::string trace;
+  gkxx::spawn_fiber(scheduler, [&] {
+    for (int i = 0; i != 3; ++i) {
+      trace += 'f';
+      gkxx::this_fiber::yield();
+    }
+  });
+  scheduler.spawn(task_steps(scheduler, trace));
+  while (scheduler.schedule())
+    ;
+  assert(trace == "ftftft");
+  std::cout << "interleaving: OK\n";
+}
+
+gkxx::Task<int> answer(gkxx::Scheduler &scheduler) {
+  co_await scheduler.suspend();
+  co_return 42;
+}
+
+gkxx::Task<int> failing(gkxx::Scheduler &scheduler) {
+  co_await scheduler.suspend();
+  throw std::runtime_error{"failed"};
+}
+
+// Plain function deep down the fiber's stack that blocks on a coroutine.
+int legacy_call(int depth) {
+  volatile char buffer[256];
+  buffer[0] = static_cast<char>(depth);
+  if (depth != 0)
+    return legacy_call(depth - 1) + buffer[0] - depth;
+  return gkxx::this_fiber::await(answer(gkxx::this_fiber::scheduler()));
+}
+
+void awaiting() {
+  using namespace std::chrono_literals;
+  gkxx::Scheduler scheduler{};
+  int result = 0;
+  bool caught = false;
+  std::chrono::steady_clock::duration slept{};
+  gkxx::spawn_fiber(scheduler, [&] {
+    result = legacy_call(100);
+    try {
+      gkxx::this_fiber::await(failing(scheduler));
+    } catch (const std::runtime_error &) {
+      caught = true;
+    }
+    auto start = std::chrono::steady_clock::now();
+    gkxx::this_fiber::await(scheduler.sleep_for(5ms));
+    slept = std::chrono::steady_clock::now() - start;
+  });
+  while (scheduler.schedule())
+    ;
+  assert(result == 42 && caught && slept >= 5ms);
+  std::cout << "await from a fiber: OK\n";
+}
+
+gkxx::Task<> produce(gkxx::Channel<int> &out) {
+  for (int i = 1; i <= 100; ++i)
+    co_await out.send(i);
+  out.close();
+}
+
+void channel() {
+  gkxx::Scheduler scheduler{};
+  gkxx::Channel<int> ch{scheduler, 4};
+  long sum = 0;
+  gkxx::spawn_fiber(scheduler, [&] {
+    while (auto x = gkxx::this_fiber::await(ch.recv()))
+      sum += *x;
+  });
+  scheduler.spawn(produce(ch));
+  while (scheduler.schedule())
+    ;
+  assert(sum == 5050);
+  std::cout << "fiber receiving from a task: OK\n";
+}
+
+// Stacks go back to the pool and are reused.
+void stack_reuse() {
+  gkxx::Scheduler scheduler{};
+  gkxx::FiberStackPool pool{16 * 1024, true, 4};
+  int done = 0;
+  for (int round = 0; round != 100; ++round) {
+    for (int i = 0; i != 4; ++i)
+      gkxx::spawn_fiber(
+          scheduler,
+          [&] {
+            gkxx::this_fiber::yield();
+            ++done;
+          },
+          pool);
+    while (scheduler.schedule())
+      ;
+  }
+  assert(done == 400);
+  std::cout << "stack reuse: OK\n";
+}
+
+struct throws_on_move {
+  throws_on_move() = default;
+  throws_on_move(throws_on_move &&) {
+    throw std::runtime_error{"move"};
+  }
+  void operator()() {}
+};
+
+// A fiber that fails to start gives its stack back.
+void failed_spawn() {
+  gkxx::Scheduler scheduler{};
+  gkxx::FiberStackPool pool{16 * 1024, true, 4};
+  auto top = pool.allocate();
+  pool.deallocate(top);
+  bool thrown = false;
+  try {
+    gkxx::spawn_fiber(scheduler, throws_on_move{}, pool);
+  } catch (const std::runtime_error &) {
+    thrown = true;
+  }
+  assert(thrown && pool.allocate() == top);
+  assert(!scheduler.schedule());
+  std::cout << "failed spawn: OK\n";
+}
+
+int main() {
+  interleaving();
+  awaiting();
+  channel();
+  stack_reuse();
+  failed_spawn();
+  return 0;
+}
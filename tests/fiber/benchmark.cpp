@@ -0,0 +1,102 @@
+// Stackful fibers against stackless tasks on the same Scheduler: the cost
+// of one switch (a task or fiber yielding and being resumed through the run
+// queue, `tasks` of them taking turns), and the resident memory per
+// suspended task with `concurrent` of them alive at once. Fiber stacks are
+// `stack_kb` KiB of address space, of which only the touched pages count.
+// Guard pages are dropped when vm.max_map_count is too low for them.
+//
+// usage: benchmark [concurrent] [stack_kb] [tasks] [rounds]
+#include "../../coro/fiber.hpp"
+#include "../../coro/scheduler.hpp"
+#include "../../tictoc.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+long resident_kb() {
+  std::ifstream status{"/proc/self/status"};
+  for (std::string line; std::getline(status, line);)
+    if (line.rfind("VmRSS:", 0) == 0)
+      return std::stol(line.substr(6));
+  return 0;
+}
+
+long max_map_count() {
+  std::ifstream in{"/proc/sys/vm/max_map_count"};
+  long ret = 65530;
+  in >> ret;
+  return ret;
+}
+
+gkxx::Task<> yielding_task(gkxx::Scheduler &scheduler, long rounds) {
+  for (long i = 0; i != rounds; ++i)
+    co_await scheduler.suspend();
+}
+
+double run_ns_per_switch(gkxx::Scheduler &scheduler, long switches) {
+  auto clock = gkxx::tic();
+  while (scheduler.schedule())
+    ;
+  return std::chrono::duration<double, std::nano>(gkxx::toc(clock)).count() /
+         static_cast<double>(switches);
+}
+
+// Runs until every task has started and suspended once, and returns the
+// growth of the resident set per task.
+double bytes_per_task(gkxx::Scheduler &scheduler, long concurrent,
+                      long baseline_kb) {
+  for (long i = 0; i != concurrent; ++i)
+    scheduler.schedule();
+  auto grown = resident_kb() - baseline_kb;
+  while (scheduler.schedule())
+    ;
+  return 1024.0 * static_cast<double>(grown) /
+         static_cast<double>(concurrent);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  long concurrent = argc > 1 ? std::stol(argv[1]) : 1000000;
+  std::size_t stack_kb = argc > 2 ? std::stoul(argv[2]) : 16;
+  long tasks = argc > 3 ? std::stol(argv[3]) : 100;
+  long rounds = argc > 4 ? std::stol(argv[4]) : 100000;
+  bool guard = 2 * concurrent + 1000 < max_map_count();
+
+  gkxx::FiberStackPool pool{stack_kb * 1024, guard, 256};
+  gkxx::Scheduler scheduler{};
+
+  for (long i = 0; i != tasks; ++i)
+    scheduler.spawn(yielding_task(scheduler, rounds));
+  auto task_switch = run_ns_per_switch(scheduler, tasks * rounds);
+  for (long i = 0; i != tasks; ++i)
+    gkxx::spawn_fiber(
+        scheduler,
+        [rounds] {
+          for (long r = 0; r != rounds; ++r)
+            gkxx::this_fiber::yield();
+        },
+        pool);
+  auto fiber_switch = run_ns_per_switch(scheduler, tasks * rounds);
+  std::printf("switch, %ld tasks taking turns: %.1f ns stackless, %.1f ns "
+              "fiber\n",
+              tasks, task_switch, fiber_switch);
+
+  auto baseline = resident_kb();
+  for (long i = 0; i != concurrent; ++i)
+    scheduler.spawn(yielding_task(scheduler, 1));
+  auto task_bytes = bytes_per_task(scheduler, concurrent, baseline);
+  baseline = resident_kb();
+  for (long i = 0; i != concurrent; ++i)
+    gkxx::spawn_fiber(
+        scheduler, [] { gkxx::this_fiber::yield(); }, pool);
+  auto fiber_bytes = bytes_per_task(scheduler, concurrent, baseline);
+  std::printf("memory, %ld suspended at once: %.0f bytes per stackless "
+              "task, %.0f bytes per fiber (%zu KiB stacks, %s guard pages)\n",
+              concurrent, task_bytes, fiber_bytes, stack_kb,
+              guard ? "with" : "without");
+  return 0;
+}
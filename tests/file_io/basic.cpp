@@ -0,0 +1,104 @@
+#include "../../coro/file_io.hpp"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+constexpr std::size_t block = 4096, blocks = 64;
+
+std::byte pattern(std::size_t i) {
+  return static_cast<std::byte>(i * 7 + i / block);
+}
+
+gkxx::Task<> write_block(gkxx::FileIo &io, int fd, std::size_t b) {
+  std::vector<std::byte> data(block);
+  for (std::size_t i = 0; i != block; ++i)
+    data[i] = pattern(b * block + i);
+  auto n = co_await io.write(fd, data, b * block);
+  assert(n == block);
+}
+
+template <typename File>
+gkxx::Task<> check_block(gkxx::FileIo &io, File file, std::byte *buffer,
+                         std::size_t b, bool fixed, int &checked) {
+  std::size_t n;
+  if (fixed)
+    n = co_await io.read_fixed(file, {buffer, block}, b * block, 0);
+  else
+    n = co_await io.read(file, {buffer, block}, b * block);
+  assert(n == block);
+  for (std::size_t i = 0; i != block; ++i)
+    assert(buffer[i] == pattern(b * block + i));
+  ++checked;
+}
+
+gkxx::Task<> read_past_end(gkxx::FileIo &io, int fd) {
+  std::byte buffer[16];
+  assert(co_await io.read(fd, buffer, block * blocks) == 0);
+}
+
+gkxx::Task<> bad_fd(gkxx::FileIo &io) {
+  std::byte buffer[16];
+  try {
+    co_await io.read(-1, buffer, 0);
+    assert(false);
+  } catch (const std::system_error &e) {
+    assert(e.code().value() == EBADF);
+  }
+}
+
+void run(gkxx::FileIoBackend backend, const std::string &path) {
+  gkxx::Scheduler scheduler{};
+  gkxx::FileIo io{scheduler, backend};
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  assert(fd >= 0);
+
+  for (std::size_t b = 0; b != blocks; ++b)
+    scheduler.spawn(write_block(io, fd, b));
+  while (scheduler.schedule())
+    ;
+
+  // One registered buffer holding a slot per block, one registered file.
+  std::vector<std::byte> buffers(block * blocks);
+  ::iovec iov{buffers.data(), buffers.size()};
+  io.register_buffers({&iov, 1});
+  io.register_files({&fd, 1});
+  int checked = 0;
+  for (std::size_t b = 0; b != blocks; ++b) {
+    auto buffer = buffers.data() + b * block;
+    switch (b % 3) {
+    case 0:
+      scheduler.spawn(check_block(io, fd, buffer, b, false, checked));
+      break;
+    case 1:
+      scheduler.spawn(
+          check_block(io, gkxx::FixedFile{0}, buffer, b, false, checked));
+      break;
+    default:
+      scheduler.spawn(
+          check_block(io, gkxx::FixedFile{0}, buffer, b, true, checked));
+    }
+  }
+  scheduler.spawn(read_past_end(io, fd));
+  scheduler.spawn(bad_fd(io));
+  while (scheduler.schedule())
+    ;
+  assert(checked == static_cast<int>(blocks));
+  auto &stats = io.stats();
+  std::cout << (io.uses_io_uring() ? "io_uring" : "thread pool") << ": "
+            << stats.operations << " operations, " << stats.submit_calls
+            << " submissions, " << stats.wakeups << " wakeups\n";
+  ::close(fd);
+}
+
+int main() {
+  auto path = "/tmp/gkxx_file_io." + std::to_string(::getpid());
+  run(gkxx::FileIoBackend::automatic, path);
+  run(gkxx::FileIoBackend::thread_pool, path);
+  ::unlink(path.c_str());
+  return 0;
+}
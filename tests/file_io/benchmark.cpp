@@ -0,0 +1,125 @@
+// Random 4KiB reads from a (page-cached) file: blocking pread in a loop
+// against FileIo with io_uring, io_uring with registered buffers and files,
+// and the thread-pool fallback. "syscalls/op" counts what the scheduler
+// thread itself issues: io_uring_enter, plus epoll_wait and an eventfd
+// read per completion wakeup.
+//
+// usage: benchmark [file MiB] [operations] [concurrent tasks]
+#include "../../coro/file_io.hpp"
+#include "../../tictoc.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t block = 4096;
+
+struct Xorshift {
+  std::uint64_t state;
+  std::uint64_t operator()() noexcept {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+};
+
+std::uint64_t checksum = 0;
+
+gkxx::Task<> reader(gkxx::FileIo &io, int fd, std::byte *buffer,
+                    std::size_t blocks, int ops, unsigned buffer_index,
+                    bool registered, std::uint64_t seed) {
+  Xorshift rng{seed};
+  for (int i = 0; i != ops; ++i) {
+    auto offset = rng() % blocks * block;
+    std::size_t n;
+    if (registered)
+      n = co_await io.read_fixed(gkxx::FixedFile{0}, {buffer, block}, offset,
+                                 buffer_index);
+    else
+      n = co_await io.read(fd, {buffer, block}, offset);
+    checksum += n + static_cast<std::uint64_t>(buffer[0]);
+  }
+}
+
+void report(const char *name, int ops, double seconds, double syscalls) {
+  std::printf("  %-34s %10.0f IOPS   %5.2f syscalls/op\n", name, ops / seconds,
+              syscalls / ops);
+}
+
+void run_file_io(const char *name, gkxx::FileIoBackend backend,
+                 bool registered, int fd, std::size_t blocks, int ops,
+                 int tasks) {
+  gkxx::Scheduler scheduler{};
+  gkxx::FileIo io{scheduler, backend};
+  std::vector<std::byte> buffers(block * static_cast<std::size_t>(tasks));
+  if (registered) {
+    std::vector<::iovec> iovs;
+    for (int t = 0; t != tasks; ++t)
+      iovs.push_back({buffers.data() + block * static_cast<std::size_t>(t),
+                      block});
+    io.register_buffers(iovs);
+    io.register_files({&fd, 1});
+  }
+  for (int t = 0; t != tasks; ++t)
+    scheduler.spawn(reader(io, fd,
+                           buffers.data() + block * static_cast<std::size_t>(t),
+                           blocks, ops / tasks, static_cast<unsigned>(t),
+                           registered, static_cast<std::uint64_t>(t) + 1));
+  auto start = gkxx::tic();
+  while (scheduler.schedule())
+    ;
+  auto seconds = std::chrono::duration<double>(gkxx::toc(start)).count();
+  auto &stats = io.stats();
+  report(name, static_cast<int>(stats.operations), seconds,
+         static_cast<double>(stats.submit_calls + 2 * stats.wakeups));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t mib = argc > 1 ? std::stoul(argv[1]) : 64;
+  int ops = argc > 2 ? std::stoi(argv[2]) : 200000;
+  int tasks = argc > 3 ? std::stoi(argv[3]) : 64;
+  auto path = "/tmp/gkxx_file_io_benchmark." + std::to_string(::getpid());
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    std::perror("open");
+    return 1;
+  }
+  std::vector<char> chunk(1 << 20, 'x');
+  for (std::size_t i = 0; i != mib; ++i)
+    if (::write(fd, chunk.data(), chunk.size()) < 0)
+      std::perror("write");
+  auto blocks = mib * (1 << 20) / block;
+  std::printf("%d random 4KiB reads from a %zuMiB file, %d tasks\n", ops, mib,
+              tasks);
+
+  {
+    std::vector<std::byte> buffer(block);
+    Xorshift rng{42};
+    auto start = gkxx::tic();
+    for (int i = 0; i != ops; ++i)
+      checksum += static_cast<std::uint64_t>(
+          ::pread(fd, buffer.data(), block,
+                  static_cast<off_t>(rng() % blocks * block)));
+    auto seconds = std::chrono::duration<double>(gkxx::toc(start)).count();
+    report("blocking pread", ops, seconds, ops);
+  }
+  run_file_io("FileIo, io_uring", gkxx::FileIoBackend::automatic, false, fd,
+              blocks, ops, tasks);
+  run_file_io("FileIo, io_uring, registered", gkxx::FileIoBackend::automatic,
+              true, fd, blocks, ops, tasks);
+  run_file_io("FileIo, thread pool", gkxx::FileIoBackend::thread_pool, false,
+              fd, blocks, ops, tasks);
+  std::printf("(checksum %llu)\n", static_cast<unsigned long long>(checksum));
+  ::close(fd);
+  ::unlink(path.c_str());
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include "../../coro/frame_pool.hpp"
+#include "../../coro/task.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+std::atomic<long> live_blocks{0};
+
+// Kept out of line so that GCC does not see the malloc and free through
+// them and warn about mismatched new and delete.
+[[gnu::noinline]] void *operator new(std::size_t size) {
+  ++live_blocks;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+[[gnu::noinline]] void operator delete(void *p) noexcept {
+  if (p)
+    --live_blocks;
+  std::free(p);
+}
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept {
+  if (p)
+    --live_blocks;
+  std::free(p);
+}
+
+void same_thread() {
+  std::vector<void *> frames;
+  for (std::size_t size : {1, 40, 48, 100, 500, 1000, 4000, 5000, 100000}) {
+    auto p = gkxx::FramePool::allocate(size);
+    assert(reinterpret_cast<std::uintptr_t>(p) %
+               __STDCPP_DEFAULT_NEW_ALIGNMENT__ ==
+           0);
+    std::memset(p, 0xab, size);
+    frames.push_back(p);
+  }
+  for (auto p : frames)
+    gkxx::FramePool::deallocate(p);
+
+  // Recycled frames do not allocate.
+  auto before = live_blocks.load();
+  for (int i = 0; i != 1000; ++i)
+    gkxx::FramePool::deallocate(gkxx::FramePool::allocate(100));
+  assert(live_blocks.load() == before);
+  std::cout << "same thread: OK\n";
+}
+
+void cross_thread() {
+  constexpr int count = 10000;
+  std::vector<void *> frames(count);
+  std::thread producer{[&] {
+    for (auto &p : frames)
+      p = gkxx::FramePool::allocate(200);
+    // The producer exits with all of its frames alive; the pool outlives
+    // it until the consumer has freed them.
+  }};
+  producer.join();
+  std::thread consumer{[&] {
+    for (auto p : frames)
+      gkxx::FramePool::deallocate(p);
+  }};
+  consumer.join();
+
+  // Frames freed remotely come back to the owner's lists.
+  std::thread owner{[] {
+    std::vector<void *> mine(count);
+    for (auto &p : mine)
+      p = gkxx::FramePool::allocate(200);
+    std::thread other{[&] {
+      for (auto p : mine)
+        gkxx::FramePool::deallocate(p);
+    }};
+    other.join();
+    auto before = live_blocks.load();
+    for (auto &p : mine)
+      p = gkxx::FramePool::allocate(200);
+    assert(live_blocks.load() - before < 100);
+    for (auto p : mine)
+      gkxx::FramePool::deallocate(p);
+  }};
+  owner.join();
+  std::cout << "cross thread: OK\n";
+}
+
+std::atomic<int> finished{0};
+
+gkxx::Task<int> leaf(gkxx::WorkStealingScheduler &pool, int x) {
+  co_await pool.suspend();
+  co_return x;
+}
+
+gkxx::Task<> parent(gkxx::WorkStealingScheduler &pool, int n) {
+  int sum = 0;
+  for (int i = 0; i != n; ++i)
+    sum += co_await leaf(pool, i);
+  assert(sum == n * (n - 1) / 2);
+  ++finished;
+}
+
+void tasks() {
+  auto before = live_blocks.load();
+  // Spawned from a thread of its own, so that every pool involved is gone
+  // once it and the workers have exited.
+  std::thread{[] {
+    gkxx::WorkStealingScheduler pool{4};
+    for (int i = 0; i != 1000; ++i)
+      pool.spawn(parent(pool, 100));
+    pool.wait_idle();
+  }}.join();
+  assert(finished.load() == 1000);
+  assert(live_blocks.load() == before);
+  std::cout << "tasks on 4 workers: OK\n";
+}
+
+int main() {
+  same_thread();
+  cross_thread();
+  tasks();
+  return 0;
+}
@@ -0,0 +1,171 @@
+// Allocation counts and throughput for short-lived Tasks. Build it twice,
+// once as is and once with -DGKXX_CORO_NO_FRAME_POOL, to compare pooled
+// frames against the global operator new.
+//
+// usage: benchmark [tasks] [workers]
+#include "../../coro/frame_pool.hpp"
+#include "../../coro/scheduler.hpp"
+#include "../../coro/task.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include "../../tictoc.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+std::atomic<long> total{0};
+
+gkxx::Task<int> leaf(int x) {
+  co_return x;
+}
+
+// One frame per task plus one per awaited leaf, all freed right away on
+// the same thread.
+gkxx::Task<> short_task(int x) {
+  total.fetch_add(co_await leaf(x), std::memory_order_relaxed);
+}
+
+// Suspends once, so that on a pool the frame is likely freed by a worker
+// other than the one that allocated it.
+gkxx::Task<> hopping_task(gkxx::WorkStealingScheduler &pool, int x) {
+  co_await pool.suspend();
+  total.fetch_add(co_await leaf(x), std::memory_order_relaxed);
+}
+
+void report(const char *name, std::size_t count, gkxx::Clock start,
+            std::size_t before, const char *unit = "task") {
+  auto elapsed = std::chrono::duration<double>(gkxx::toc(start)).count();
+  auto allocated = allocations.load() - before;
+  std::printf("  %-30s %10.0f %ss/s   %7.4f allocations/%s\n", name,
+              static_cast<double>(count) / elapsed, unit,
+              static_cast<double>(allocated) / static_cast<double>(count),
+              unit);
+}
+
+void raw(std::size_t count) {
+  constexpr std::size_t sizes[] = {96, 160, 320, 160};
+  std::vector<void *> frames(256);
+  auto before = allocations.load();
+  auto start = gkxx::tic();
+  for (std::size_t i = 0; i < count; i += frames.size()) {
+    for (std::size_t j = 0; j != frames.size(); ++j)
+      frames[j] = gkxx::FramePool::allocate(sizes[j % 4]);
+    for (auto p : frames)
+      gkxx::FramePool::deallocate(p);
+  }
+  report("FramePool, same thread", count, start, before, "frame");
+
+  before = allocations.load();
+  start = gkxx::tic();
+  for (std::size_t i = 0; i < count; i += frames.size()) {
+    for (std::size_t j = 0; j != frames.size(); ++j)
+      frames[j] = ::operator new(sizes[j % 4]);
+    for (auto p : frames)
+      ::operator delete(p);
+  }
+  report("operator new, same thread", count, start, before, "frame");
+
+  // Producer allocates, consumer frees: every free is remote.
+  for (bool pooled : {true, false}) {
+    std::atomic<void *> slot{nullptr};
+    before = allocations.load();
+    start = gkxx::tic();
+    std::thread consumer{[&] {
+      for (std::size_t i = 0; i != count; ++i) {
+        void *p;
+        while (!(p = slot.exchange(nullptr, std::memory_order_acquire)))
+          std::this_thread::yield();
+        if (pooled)
+          gkxx::FramePool::deallocate(p);
+        else
+          ::operator delete(p);
+      }
+    }};
+    for (std::size_t i = 0; i != count; ++i) {
+      auto p = pooled ? gkxx::FramePool::allocate(160) : ::operator new(160);
+      while (slot.load(std::memory_order_relaxed))
+        std::this_thread::yield();
+      slot.store(p, std::memory_order_release);
+    }
+    consumer.join();
+    report(pooled ? "FramePool, freed remotely"
+                  : "operator new, freed remotely",
+           count, start, before, "frame");
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t tasks = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  std::size_t workers = argc > 2 ? std::stoul(argv[2]) : 4;
+  // Tasks are spawned in batches, as a server would keep a bounded number
+  // of them alive at a time.
+  constexpr std::size_t batch = 256;
+#ifdef GKXX_CORO_NO_FRAME_POOL
+  std::printf("Task frames from operator new\n");
+#else
+  std::printf("Task frames from FramePool\n");
+#endif
+
+  {
+    gkxx::Scheduler scheduler{};
+    // Warm up the scheduler's queues and the frame pool.
+    for (std::size_t i = 0; i != batch; ++i)
+      scheduler.spawn(short_task(1));
+    while (scheduler.schedule())
+      ;
+    auto before = allocations.load();
+    auto start = gkxx::tic();
+    for (std::size_t i = 0; i < tasks; i += batch) {
+      for (std::size_t j = 0; j != batch; ++j)
+        scheduler.spawn(short_task(1));
+      while (scheduler.schedule())
+        ;
+    }
+    report("Scheduler", tasks, start, before);
+  }
+  {
+    gkxx::WorkStealingScheduler pool{workers};
+    for (std::size_t i = 0; i != batch; ++i)
+      pool.spawn(hopping_task(pool, 1));
+    pool.wait_idle();
+    auto before = allocations.load();
+    auto start = gkxx::tic();
+    for (std::size_t i = 0; i < tasks; i += batch) {
+      for (std::size_t j = 0; j != batch; ++j)
+        pool.spawn(hopping_task(pool, 1));
+      pool.wait_idle();
+    }
+    report(("WorkStealingScheduler x" + std::to_string(workers)).c_str(),
+           tasks, start, before);
+  }
+  std::printf("Raw allocation, 4 frame sizes:\n");
+  raw(tasks);
+  return total.load() == 0;
+}
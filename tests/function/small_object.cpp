@@ -0,0 +1,112 @@
+#include "../../function.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+
+std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+int add(int x, int y) {
+  return x + y;
+}
+
+struct counted {
+  static inline int alive = 0;
+  int value;
+  explicit counted(int v) : value{v} {
+    ++alive;
+  }
+  counted(const counted &other) : value{other.value} {
+    ++alive;
+  }
+  counted(counted &&other) noexcept : value{other.value} {
+    ++alive;
+  }
+  ~counted() {
+    --alive;
+  }
+  int operator()(int x, int y) const {
+    return value + x + y;
+  }
+};
+
+// Its move constructor may throw, so it is never stored in place.
+struct throwing_move {
+  int value;
+  throwing_move(int v) : value{v} {}
+  throwing_move(const throwing_move &) = default;
+  throwing_move(throwing_move &&other) : value{other.value} {}
+  int operator()(int x, int y) const {
+    return value * (x + y);
+  }
+};
+
+using fn = gkxx::function<int(int, int)>;
+
+int main() {
+  int a = 1, b = 2, c = 3;
+  auto before = allocations;
+  {
+    fn from_pointer = add;
+    fn captureless = [](int x, int y) { return x * y; };
+    fn three_pointers = [pa = &a, pb = &b, pc = &c](int x, int y) {
+      return *pa + *pb + *pc + x + y;
+    };
+    static_assert(noexcept(fn{add}));
+
+    fn copy = three_pointers;
+    fn moved = std::move(copy);
+    from_pointer.swap(captureless);
+    captureless = moved;
+    assert(!copy && from_pointer(3, 4) == 12 && captureless(1, 1) == 8 &&
+           moved(0, 0) == 6 && three_pointers(1, 0) == 7);
+    fn pointer_copy = fn{add};
+    assert(*pointer_copy.target<int (*)(int, int)>() == add);
+  }
+  assert(allocations == before);
+  std::cout << "small targets: no allocations\n";
+
+  {
+    fn big = [a, b, c, d = 4, e = 5, f = 6, g = 7, h = 8](int x, int y) {
+      return a + b + c + d + e + f + g + h + x + y;
+    };
+    assert(allocations == before + 1);
+    fn small = counted{10};
+    fn heap = throwing_move{2};
+    assert(allocations == before + 2);
+
+    // Swapping moves in-place targets and hands over heap ones.
+    small.swap(big);
+    assert(big(1, 2) == 13 && small(0, 0) == 36);
+    heap.swap(big);
+    assert(heap(0, 0) == 10 && big(1, 2) == 6);
+    assert(heap.target<counted>() && heap.target<counted>()->value == 10);
+    assert(big.target_type() == typeid(throwing_move));
+    assert(allocations == before + 2);
+
+    fn copy = heap;
+    fn heap_copy = big;
+    assert(allocations == before + 3 && counted::alive == 2);
+    copy = nullptr;
+    heap = std::move(heap_copy);
+    assert(heap(1, 1) == 4 && !heap_copy && counted::alive == 0);
+  }
+  assert(counted::alive == 0);
+  std::cout << "large targets: OK\n";
+  return 0;
+}
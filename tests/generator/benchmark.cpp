@@ -0,0 +1,281 @@
+#include "../../generator.hpp"
+#include "../../tictoc.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+
+#if __has_include(<generator>)
+#include <generator>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Usage: benchmark [N]
+// Prints ns/element, heap allocations per generator and retired
+// instructions per element (when perf_event_open is permitted). The
+// allocation count includes allocations made by the yielded values
+// themselves, e.g. one per element for `string`.
+
+static std::size_t allocation_count = 0;
+
+void *operator new(std::size_t size) {
+  ++allocation_count;
+  if (auto ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc{};
+}
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+class InstructionCounter {
+  int m_fd = -1;
+
+ public:
+  InstructionCounter() {
+#ifdef __linux__
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = static_cast<int>(
+        ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  InstructionCounter(const InstructionCounter &) = delete;
+  ~InstructionCounter() {
+#ifdef __linux__
+    if (m_fd != -1)
+      ::close(m_fd);
+#endif
+  }
+  bool available() const noexcept {
+    return m_fd != -1;
+  }
+  void start() noexcept {
+#ifdef __linux__
+    if (m_fd != -1) {
+      ::ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  long long stop() noexcept {
+    long long count = -1;
+#ifdef __linux__
+    if (m_fd != -1) {
+      ::ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (::read(m_fd, &count, sizeof(count)) != sizeof(count))
+        count = -1;
+    }
+#endif
+    return count;
+  }
+};
+
+struct IntKind {
+  using type = unsigned;
+  static constexpr const char *name = "int";
+  static type make(unsigned i) noexcept {
+    return i;
+  }
+  static std::uint64_t consume(type const &x) noexcept {
+    return x * x;
+  }
+};
+
+struct LargeKind {
+  struct type {
+    std::uint64_t data[16];
+  };
+  static constexpr const char *name = "large(128B)";
+  static type make(unsigned i) noexcept {
+    type ret;
+    for (auto &d : ret.data)
+      d = i++;
+    return ret;
+  }
+  static std::uint64_t consume(type const &x) noexcept {
+    return x.data[0] ^ x.data[15];
+  }
+};
+
+struct StringKind {
+  using type = std::string;
+  static constexpr const char *name = "string";
+  static type make(unsigned i) {
+    std::string ret(32, 'x');
+    ret[i % 32] = static_cast<char>('a' + i % 26);
+    return ret;
+  }
+  static std::uint64_t consume(type const &x) noexcept {
+    return static_cast<unsigned char>(x[x.size() / 2]) + x.size();
+  }
+};
+
+template <typename Kind>
+gkxx::Generator<typename Kind::type> gkxx_source(unsigned n) {
+  for (unsigned i{}; i != n; ++i)
+    co_yield Kind::make(i);
+}
+
+#if __cpp_lib_generator >= 202207L
+template <typename Kind>
+std::generator<typename Kind::type> std_source(unsigned n) {
+  for (unsigned i{}; i != n; ++i)
+    co_yield Kind::make(i);
+}
+#endif
+
+template <typename Kind, typename Visitor>
+void callback_source(unsigned n, Visitor &&visitor) {
+  for (unsigned i{}; i != n; ++i)
+    visitor(Kind::make(i));
+}
+
+template <typename Kind>
+class iterator_source {
+  unsigned m_n;
+
+ public:
+  explicit iterator_source(unsigned n) : m_n{n} {}
+
+  class iterator {
+    unsigned m_i;
+    typename Kind::type m_value;
+
+   public:
+    explicit iterator(unsigned i) : m_i{i}, m_value(Kind::make(i)) {}
+    typename Kind::type const &operator*() const noexcept {
+      return m_value;
+    }
+    iterator &operator++() {
+      m_value = Kind::make(++m_i);
+      return *this;
+    }
+    bool operator==(unsigned end) const noexcept {
+      return m_i == end;
+    }
+  };
+
+  iterator begin() const {
+    return iterator{0};
+  }
+  unsigned end() const noexcept {
+    return m_n;
+  }
+};
+
+template <typename Kind>
+struct Competitors {
+  static std::uint64_t gkxx_generator(unsigned n) {
+    std::uint64_t result{};
+    for (auto const &x : gkxx_source<Kind>(n))
+      result += Kind::consume(x);
+    return result;
+  }
+#if __cpp_lib_generator >= 202207L
+  static std::uint64_t std_generator(unsigned n) {
+    std::uint64_t result{};
+    for (auto const &x : std_source<Kind>(n))
+      result += Kind::consume(x);
+    return result;
+  }
+#endif
+  static std::uint64_t callback(unsigned n) {
+    std::uint64_t result{};
+    callback_source<Kind>(
+        n, [&](typename Kind::type const &x) { result += Kind::consume(x); });
+    return result;
+  }
+  static std::uint64_t hand_iterator(unsigned n) {
+    std::uint64_t result{};
+    for (auto const &x : iterator_source<Kind>(n))
+      result += Kind::consume(x);
+    return result;
+  }
+  static std::uint64_t plain_loop(unsigned n) {
+    std::uint64_t result{};
+    for (unsigned i{}; i != n; ++i)
+      result += Kind::consume(Kind::make(i));
+    return result;
+  }
+};
+
+template <typename Func>
+void run(std::string_view kind, std::string_view name, Func func, unsigned n,
+         InstructionCounter &counter) {
+  // One warm-up round, then one measured round.
+  volatile auto sink = func(n);
+  auto allocations_before = allocation_count;
+  counter.start();
+  auto clock = gkxx::tic();
+  sink = func(n);
+  auto elapsed = gkxx::toc(clock);
+  auto instructions = counter.stop();
+  auto allocations = allocation_count - allocations_before;
+  (void)sink;
+
+  auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  std::cout << std::left << std::setw(12) << kind << std::setw(16) << name
+            << std::right << std::fixed << std::setprecision(3) << std::setw(12)
+            << ns / n << std::setw(14) << allocations << std::setw(14);
+  if (instructions >= 0)
+    std::cout << static_cast<double>(instructions) / n;
+  else
+    std::cout << "n/a";
+  std::cout << '\n';
+}
+
+template <typename Kind>
+void run_all(unsigned n, InstructionCounter &counter) {
+  using C = Competitors<Kind>;
+  run(Kind::name, "gkxx::Generator", C::gkxx_generator, n, counter);
+#if __cpp_lib_generator >= 202207L
+  run(Kind::name, "std::generator", C::std_generator, n, counter);
+#endif
+  run(Kind::name, "callback", C::callback, n, counter);
+  run(Kind::name, "hand iterator", C::hand_iterator, n, counter);
+  run(Kind::name, "plain loop", C::plain_loop, n, counter);
+}
+
+int main(int argc, char **argv) {
+  unsigned n = argc > 1
+                   ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10))
+                   : 10000000u;
+  if (n == 0)
+    n = 1;
+  InstructionCounter counter;
+  std::cout << "N = " << n << '\n';
+#if __cpp_lib_generator < 202207L
+  std::cout << "std::generator is not available in this standard library\n";
+#endif
+  if (!counter.available())
+    std::cout << "perf_event_open is not permitted, instructions are n/a\n";
+  std::cout << std::left << std::setw(12) << "type" << std::setw(16)
+            << "source" << std::right << std::setw(12) << "ns/elem"
+            << std::setw(14) << "allocs/gen" << std::setw(14) << "instr/elem"
+            << '\n';
+  run_all<IntKind>(n, counter);
+  run_all<LargeKind>(n, counter);
+  run_all<StringKind>(n, counter);
+  return 0;
+}
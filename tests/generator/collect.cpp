@@ -0,0 +1,34 @@
+#include "../../generator.hpp"
+#include <iostream>
+#include <list>
+#include <set>
+#include <string>
+
+gkxx::Generator<std::string> names(unsigned n) {
+  co_yield gkxx::size_hint{n};
+  for (unsigned i{}; i != n; ++i)
+    co_yield "name" + std::to_string(i);
+}
+
+gkxx::Generator<int> unhinted(int n) {
+  for (int i = n; i != 0; --i)
+    co_yield i;
+}
+
+int main() {
+  auto v = gkxx::collect(names(1000000));
+  std::cout << "size: " << v.size() << ", capacity: " << v.capacity() << '\n';
+  if (v.capacity() != v.size() || v.back() != "name999999")
+    return 1;
+
+  auto l = gkxx::to<std::list>(names(3));
+  for (auto const &s : l)
+    std::cout << s << ' ';
+  std::cout << '\n';
+
+  auto s = gkxx::to<std::set<int>>(unhinted(5));
+  for (auto i : s)
+    std::cout << i << ' ';
+  std::cout << '\n';
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include "../../coro/mpmc_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+template <typename Queue, typename Push>
+std::uint64_t transfer(Queue &queue, Push push, unsigned producers,
+                       unsigned consumers, unsigned per_producer) {
+  std::atomic<std::uint64_t> sum{0};
+  std::atomic<unsigned> received{0};
+  const unsigned total = producers * per_producer;
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p != producers; ++p)
+    threads.emplace_back([&, p] {
+      for (unsigned i = 0; i != per_producer; ++i)
+        push(queue, p * per_producer + i + 1);
+    });
+  for (unsigned c = 0; c != consumers; ++c)
+    threads.emplace_back([&] {
+      while (received.load() != total)
+        if (auto x = queue.try_pop()) {
+          sum += *x;
+          ++received;
+        }
+    });
+  for (auto &t : threads)
+    t.join();
+  return sum;
+}
+
+int main() {
+  constexpr unsigned producers = 4, consumers = 4, per_producer = 100000;
+  constexpr std::uint64_t n = producers * per_producer;
+  constexpr std::uint64_t expected = n * (n + 1) / 2;
+
+  gkxx::MpmcQueue<unsigned> bounded{64};
+  auto bounded_sum = transfer(
+      bounded,
+      [](auto &q, unsigned x) {
+        while (!q.try_push(x))
+          std::this_thread::yield();
+      },
+      producers, consumers, per_producer);
+
+  gkxx::InjectionQueue<unsigned> unbounded{8};
+  auto unbounded_sum = transfer(
+      unbounded, [](auto &q, unsigned x) { q.push(x); }, producers, consumers,
+      per_producer);
+
+  std::cout << "bounded: " << bounded_sum << ", unbounded: " << unbounded_sum
+            << ", expected: " << expected << '\n';
+  return bounded_sum == expected && unbounded_sum == expected ? 0 : 1;
+}
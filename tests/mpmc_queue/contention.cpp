@@ -0,0 +1,75 @@
+#include "../../coro/mpmc_queue.hpp"
+#include "../../tictoc.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Usage: contention [threads_per_side] [items_per_producer]
+// Producers and consumers hammer one queue at the same time.
+
+class MutexQueue {
+  std::mutex m_mutex;
+  std::queue<unsigned> m_queue;
+
+ public:
+  void push(unsigned x) {
+    std::lock_guard lock{m_mutex};
+    m_queue.push(x);
+  }
+  std::optional<unsigned> try_pop() {
+    std::lock_guard lock{m_mutex};
+    if (m_queue.empty())
+      return std::nullopt;
+    auto x = m_queue.front();
+    m_queue.pop();
+    return x;
+  }
+};
+
+template <typename Queue>
+double run(unsigned threads, unsigned per_producer) {
+  Queue queue;
+  std::atomic<bool> go{false};
+  std::atomic<unsigned> received{0};
+  const unsigned total = threads * per_producer;
+  std::vector<std::thread> workers;
+  for (unsigned p = 0; p != threads; ++p)
+    workers.emplace_back([&] {
+      while (!go.load())
+        ;
+      for (unsigned i = 0; i != per_producer; ++i)
+        queue.push(i);
+    });
+  for (unsigned c = 0; c != threads; ++c)
+    workers.emplace_back([&] {
+      while (!go.load())
+        ;
+      while (received.load(std::memory_order_relaxed) != total)
+        if (queue.try_pop())
+          received.fetch_add(1, std::memory_order_relaxed);
+    });
+  auto clock = gkxx::tic();
+  go = true;
+  for (auto &w : workers)
+    w.join();
+  auto seconds = std::chrono::duration<double>(gkxx::toc(clock)).count();
+  return total / seconds / 1e6;
+}
+
+int main(int argc, char **argv) {
+  unsigned threads = argc > 1 ? std::atoi(argv[1]) : 4;
+  unsigned per_producer = argc > 2 ? std::atoi(argv[2]) : 1000000;
+  std::cout << threads << " producers, " << threads << " consumers\n";
+  std::cout << "InjectionQueue:       "
+            << run<gkxx::InjectionQueue<unsigned>>(threads, per_producer)
+            << " Mops/s\n";
+  std::cout << "mutex + std::queue:   " << run<MutexQueue>(threads, per_producer)
+            << " Mops/s\n";
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include "../../coro/parallel.hpp"
+#include "../../coro/scheduler.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Pool = gkxx::WorkStealingScheduler;
+
+long sum_block(auto block) {
+  long sum = 0;
+  for (long x : block)
+    sum += x;
+  return sum;
+}
+
+void sum(std::size_t grain) {
+  Pool pool{4};
+  constexpr long n = 1000000;
+  auto result = gkxx::sync_wait(
+      pool, gkxx::parallel_reduce(pool, std::views::iota(0L, n), grain, 0L,
+                                  [](auto block) { return sum_block(block); },
+                                  std::plus<>{}));
+  assert(result == n * (n - 1) / 2);
+  std::cout << "sum with grain " << grain << ": OK\n";
+}
+
+void each_once() {
+  Pool pool{4};
+  std::vector<std::atomic<int>> hits(100000);
+  gkxx::sync_wait(pool, gkxx::parallel_for(pool, hits, 0, [](auto &h) {
+                    h.fetch_add(1, std::memory_order_relaxed);
+                  }));
+  assert(std::all_of(hits.begin(), hits.end(),
+                     [](auto &h) { return h.load() == 1; }));
+  std::cout << "parallel_for visits every element once: OK\n";
+}
+
+// Concatenation is not commutative: the result shows whether the pieces
+// are combined in order.
+void in_order() {
+  Pool pool{4};
+  std::string letters(5000, ' ');
+  for (std::size_t i = 0; i != letters.size(); ++i)
+    letters[i] = static_cast<char>('a' + i % 26);
+  auto result = gkxx::sync_wait(
+      pool, gkxx::parallel_reduce(
+                pool, letters, 7, std::string{},
+                [](auto block) { return std::string(block.begin(), block.end()); },
+                [](std::string a, const std::string &b) { return a + b; }));
+  assert(result == letters);
+  std::cout << "combined in order: OK\n";
+}
+
+// Sorting by merging sorted runs.
+void merge_sort() {
+  Pool pool{4};
+  std::vector<unsigned> values(200000);
+  unsigned x = 12345;
+  for (auto &v : values)
+    v = x = x * 1103515245u + 12345u;
+  auto sorted = gkxx::sync_wait(
+      pool,
+      gkxx::parallel_reduce(
+          pool, values, 0, std::vector<unsigned>{},
+          [](auto block) {
+            std::vector<unsigned> run(block.begin(), block.end());
+            std::sort(run.begin(), run.end());
+            return run;
+          },
+          [](std::vector<unsigned> a, const std::vector<unsigned> &b) {
+            std::vector<unsigned> ret(a.size() + b.size());
+            std::merge(a.begin(), a.end(), b.begin(), b.end(), ret.begin());
+            return ret;
+          }));
+  std::sort(values.begin(), values.end());
+  assert(sorted == values);
+  std::cout << "merge sort: OK\n";
+}
+
+void exception() {
+  Pool pool{4};
+  std::atomic<int> visited{0};
+  bool caught = false;
+  try {
+    gkxx::sync_wait(pool, gkxx::parallel_for(pool, std::views::iota(0, 10000),
+                                             16, [&](int i) {
+                                               ++visited;
+                                               if (i == 5000)
+                                                 throw std::runtime_error{"x"};
+                                             }));
+  } catch (const std::runtime_error &) {
+    caught = true;
+  }
+  assert(caught && visited > 0);
+  pool.wait_idle();
+  std::cout << "exception: OK\n";
+}
+
+// A single-threaded Scheduler runs the whole range in one task.
+void on_scheduler() {
+  gkxx::Scheduler scheduler{};
+  auto result = gkxx::sync_wait(
+      scheduler,
+      gkxx::parallel_reduce(scheduler, std::views::iota(1, 101), 0, 0,
+                            [](auto block) {
+                              return std::accumulate(block.begin(),
+                                                     block.end(), 0);
+                            },
+                            std::plus<>{}));
+  assert(result == 5050);
+  std::cout << "on Scheduler: OK\n";
+}
+
+int main() {
+  sum(0);
+  sum(1);
+  sum(1000);
+  each_once();
+  in_order();
+  merge_sort();
+  exception();
+  on_scheduler();
+  return 0;
+}
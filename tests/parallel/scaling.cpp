@@ -0,0 +1,117 @@
+// parallel_for / parallel_reduce from one worker up to `max_threads`, on
+// three loops: a fine-grained sum (where the per-block bookkeeping shows,
+// compared with a plain loop), counting primes over [1, N] (cost grows
+// with n, so equal splits would be uneven), and sorting by merging sorted
+// runs.
+//
+// usage: scaling [max_threads] [n]
+#include "../../coro/parallel.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include "../../tictoc.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool is_prime(long n) {
+  if (n < 2)
+    return false;
+  for (long d = 2; d * d <= n; ++d)
+    if (n % d == 0)
+      return false;
+  return true;
+}
+
+template <typename F>
+double milliseconds(F f) {
+  auto clock = gkxx::tic();
+  f();
+  return std::chrono::duration<double, std::milli>(gkxx::toc(clock)).count();
+}
+
+volatile long sink;
+
+} // namespace
+
+int main(int argc, char **argv) {
+  unsigned max_threads = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1]))
+                                  : std::thread::hardware_concurrency();
+  long n = argc > 2 ? std::stol(argv[2]) : 20000000;
+  if (max_threads == 0)
+    max_threads = 1;
+
+  std::vector<double> data(static_cast<std::size_t>(n));
+  for (std::size_t i = 0; i != data.size(); ++i)
+    data[i] = static_cast<double>(i % 1000) * 0.5;
+  auto plain = milliseconds([&] {
+    double sum = 0;
+    for (auto x : data)
+      sum += x * x;
+    sink = static_cast<long>(sum);
+  });
+  std::printf("plain loop, sum of squares over %ld doubles: %.1f ms\n", n,
+              plain);
+
+  long prime_limit = n / 4;
+  std::vector<unsigned> values(static_cast<std::size_t>(n / 4));
+  unsigned x = 12345;
+  for (auto &v : values)
+    v = x = x * 1103515245u + 12345u;
+
+  std::printf("%8s %16s %10s %16s %16s\n", "threads", "sum of squares",
+              "overhead", "primes <= N/4", "merge sort N/4");
+  for (unsigned threads = 1; threads <= max_threads; ++threads) {
+    gkxx::WorkStealingScheduler pool{threads};
+    auto sum = milliseconds([&] {
+      sink = static_cast<long>(gkxx::sync_wait(
+          pool, gkxx::parallel_reduce(
+                    pool, data, 0, 0.0,
+                    [](auto block) {
+                      double s = 0;
+                      for (auto v : block)
+                        s += v * v;
+                      return s;
+                    },
+                    std::plus<>{})));
+    });
+    auto primes = milliseconds([&] {
+      sink = gkxx::sync_wait(
+          pool, gkxx::parallel_reduce(
+                    pool, std::views::iota(1L, prime_limit + 1), 0, 0L,
+                    [](auto block) {
+                      long count = 0;
+                      for (long k : block)
+                        count += is_prime(k);
+                      return count;
+                    },
+                    std::plus<>{}));
+    });
+    auto sort = milliseconds([&] {
+      auto sorted = gkxx::sync_wait(
+          pool,
+          gkxx::parallel_reduce(
+              pool, values, 0, std::vector<unsigned>{},
+              [](auto block) {
+                std::vector<unsigned> run(block.begin(), block.end());
+                std::sort(run.begin(), run.end());
+                return run;
+              },
+              [](std::vector<unsigned> a, const std::vector<unsigned> &b) {
+                std::vector<unsigned> ret(a.size() + b.size());
+                std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                           ret.begin());
+                return ret;
+              }));
+      sink = sorted.front();
+    });
+    std::printf("%8u %13.1f ms %9.1f%% %13.1f ms %13.1f ms\n", threads, sum,
+                100 * (sum - plain) / plain, primes, sort);
+  }
+  return 0;
+}
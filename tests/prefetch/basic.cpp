@@ -0,0 +1,26 @@
+#include "../../prefetch.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+gkxx::Generator<std::string> slow_lines(unsigned n) {
+  for (unsigned i{}; i != n; ++i) {
+    std::this_thread::sleep_for(1ms);
+    co_yield "line " + std::to_string(i);
+  }
+}
+
+int main() {
+  for (auto const &line : gkxx::prefetch(slow_lines(10), 4))
+    std::cout << line << '\n';
+  // Leaving early must stop the producer.
+  for (auto const &line : gkxx::prefetch(slow_lines(1000), 4)) {
+    std::cout << line << '\n';
+    break;
+  }
+  std::cout << std::flush;
+  return 0;
+}
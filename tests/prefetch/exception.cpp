@@ -0,0 +1,20 @@
+#include "../../prefetch.hpp"
+#include <iostream>
+#include <stdexcept>
+
+gkxx::Generator<int> failing(int n) {
+  for (int i = 0; i != n; ++i)
+    co_yield i;
+  throw std::runtime_error{"producer failed"};
+}
+
+int main() {
+  try {
+    for (auto i : gkxx::prefetch(failing(5), 2))
+      std::cout << i << ' ';
+  } catch (const std::runtime_error &e) {
+    std::cout << "caught: " << e.what() << '\n';
+    return 0;
+  }
+  return 1;
+}
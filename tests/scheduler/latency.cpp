@@ -0,0 +1,117 @@
+// Request latency on one Scheduler saturated with background work.
+// `background` tasks each spin for `slice_us` microseconds between
+// suspensions; another thread submits a request every 500us, which takes
+// three short steps to answer. In FIFO mode everything goes through plain
+// suspend(), so each step waits for a full round of background slices. In
+// priority mode the background tasks yield with Priority::background and
+// the requests with Priority::interactive.
+//
+// usage: latency [background] [slice_us] [requests]
+#include "../../coro/scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using gkxx::Priority;
+
+std::atomic<bool> done{false};
+std::atomic<int> answered{0};
+long slices = 0;
+
+void spin(std::chrono::microseconds duration) {
+  auto until = clock_type::now() + duration;
+  while (clock_type::now() < until)
+    ;
+}
+
+gkxx::Task<> background(gkxx::Scheduler &scheduler,
+                        std::chrono::microseconds slice, bool prioritized) {
+  while (!done.load(std::memory_order_relaxed)) {
+    spin(slice);
+    ++slices;
+    if (prioritized)
+      co_await scheduler.suspend(Priority::background);
+    else
+      co_await scheduler.suspend();
+  }
+}
+
+gkxx::Task<> request(gkxx::Scheduler &scheduler, clock_type::time_point sent,
+                     bool prioritized, std::vector<double> &latencies) {
+  for (int step = 0; step != 3; ++step) {
+    spin(std::chrono::microseconds{2});
+    if (prioritized)
+      co_await scheduler.suspend(Priority::interactive);
+    else
+      co_await scheduler.suspend();
+  }
+  latencies.push_back(
+      std::chrono::duration<double, std::micro>(clock_type::now() - sent)
+          .count());
+  answered.fetch_add(1, std::memory_order_release);
+}
+
+void run(const char *name, bool prioritized, int tasks,
+         std::chrono::microseconds slice, int requests) {
+  gkxx::Scheduler scheduler{};
+  std::vector<double> latencies;
+  latencies.reserve(static_cast<std::size_t>(requests));
+  done = false;
+  answered = 0;
+  slices = 0;
+  for (int i = 0; i != tasks; ++i) {
+    if (prioritized)
+      scheduler.spawn(background(scheduler, slice, true),
+                      Priority::background);
+    else
+      scheduler.spawn(background(scheduler, slice, false));
+  }
+  std::thread client{[&] {
+    auto next = clock_type::now();
+    for (int i = 0; i != requests; ++i) {
+      next += std::chrono::microseconds{500};
+      std::this_thread::sleep_until(next);
+      scheduler.submit(
+          request(scheduler, clock_type::now(), prioritized, latencies)
+              .release());
+    }
+  }};
+  auto start = clock_type::now();
+  while (answered.load(std::memory_order_acquire) != requests)
+    scheduler.schedule();
+  auto seconds = std::chrono::duration<double>(clock_type::now() - start);
+  done = true;
+  while (scheduler.schedule())
+    ;
+  client.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto at = [&](double q) {
+    return latencies[static_cast<std::size_t>(
+        q * static_cast<double>(latencies.size() - 1))];
+  };
+  std::printf("  %-9s p50 %9.1f us   p99 %9.1f us   max %9.1f us   "
+              "%8.0f background slices/s\n",
+              name, at(0.5), at(0.99), latencies.back(),
+              static_cast<double>(slices) / seconds.count());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int tasks = argc > 1 ? std::stoi(argv[1]) : 256;
+  std::chrono::microseconds slice{argc > 2 ? std::stoi(argv[2]) : 20};
+  int requests = argc > 3 ? std::stoi(argv[3]) : 2000;
+  std::printf("%d background tasks, %ld us slices, %d requests:\n", tasks,
+              static_cast<long>(slice.count()), requests);
+  run("FIFO", false, tasks, slice, requests);
+  run("priority", true, tasks, slice, requests);
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include "../../coro/scheduler.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using gkxx::Priority;
+
+gkxx::Task<> record(std::vector<std::string> &order, std::string name) {
+  order.push_back(std::move(name));
+  co_return;
+}
+
+// Classes are served in order, earliest deadline first within one, and
+// arrival order for equal deadlines.
+void ordering() {
+  gkxx::Scheduler scheduler{};
+  std::vector<std::string> order;
+  auto now = gkxx::TimerWheel::clock_type::now();
+  using namespace std::chrono_literals;
+  scheduler.spawn(record(order, "background"), Priority::background);
+  scheduler.spawn(record(order, "plain"));
+  scheduler.spawn(record(order, "normal +2ms"), Priority::normal, now + 2ms);
+  scheduler.spawn(record(order, "interactive a"), Priority::interactive);
+  scheduler.spawn(record(order, "normal +1ms"), Priority::normal, now + 1ms);
+  scheduler.spawn(record(order, "interactive +5ms"), Priority::interactive,
+                  now + 5ms);
+  scheduler.spawn(record(order, "interactive b"), Priority::interactive);
+  scheduler.spawn(record(order, "normal"), Priority::normal);
+  while (scheduler.schedule())
+    ;
+  assert((order == std::vector<std::string>{
+                       "interactive +5ms", "interactive a", "interactive b",
+                       "normal +1ms", "normal +2ms", "plain", "normal",
+                       "background"}));
+  std::cout << "ordering: OK\n";
+}
+
+gkxx::Task<> batch(gkxx::Scheduler &scheduler, int &steps) {
+  for (int i = 0; i != 100; ++i) {
+    ++steps;
+    co_await scheduler.suspend(Priority::background);
+  }
+}
+
+gkxx::Task<> interactive(gkxx::Scheduler &scheduler, const int &batch_steps,
+                         int &seen) {
+  for (int i = 0; i != 10; ++i)
+    co_await scheduler.suspend(Priority::interactive);
+  seen = batch_steps;
+  // Plain suspend() still goes ahead of background work.
+  for (int i = 0; i != 10; ++i)
+    co_await scheduler.suspend();
+  seen = batch_steps - seen;
+}
+
+// Background tasks only run while nothing else is ready.
+void preemption() {
+  gkxx::Scheduler scheduler{};
+  int steps = 0, seen = -1;
+  for (int i = 0; i != 8; ++i)
+    scheduler.spawn(batch(scheduler, steps), Priority::background);
+  scheduler.schedule();
+  scheduler.schedule();
+  scheduler.spawn(interactive(scheduler, steps, seen));
+  while (scheduler.schedule())
+    ;
+  assert(steps == 800 && seen == 0);
+  std::cout << "preemption: OK\n";
+}
+
+gkxx::Task<> sleeper(gkxx::Scheduler &scheduler, bool &woken) {
+  using namespace std::chrono_literals;
+  co_await scheduler.sleep_for(2ms);
+  woken = true;
+}
+
+gkxx::Task<> spinner(gkxx::Scheduler &scheduler, const bool &woken,
+                     long &spins) {
+  while (!woken) {
+    ++spins;
+    co_await scheduler.suspend(Priority::background);
+  }
+}
+
+// Timers are still polled with only background tasks ready.
+void timers() {
+  gkxx::Scheduler scheduler{};
+  bool woken = false;
+  long spins = 0;
+  scheduler.spawn(sleeper(scheduler, woken));
+  scheduler.spawn(spinner(scheduler, woken, spins), Priority::background);
+  while (scheduler.schedule())
+    ;
+  assert(woken && spins > 0);
+  std::cout << "timers under background load: OK\n";
+}
+
+int main() {
+  ordering();
+  preemption();
+  timers();
+  return 0;
+}
@@ -0,0 +1,31 @@
+#include "../../coro/scheduler.hpp"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+std::atomic<int> finished{0};
+
+gkxx::Task<> hop(gkxx::Scheduler &scheduler, int id) {
+  co_await scheduler.suspend();
+  if (id % 100 == 0)
+    std::cout << "task " << id << " is on the scheduler thread\n";
+  ++finished;
+}
+
+int main() {
+  constexpr int threads = 4, per_thread = 200;
+  gkxx::Scheduler scheduler{};
+  std::vector<std::thread> submitters;
+  for (int t = 0; t != threads; ++t)
+    submitters.emplace_back([&, t] {
+      for (int i = 0; i != per_thread; ++i)
+        scheduler.submit(hop(scheduler, t * per_thread + i).release());
+    });
+  while (finished != threads * per_thread)
+    scheduler.schedule();
+  for (auto &t : submitters)
+    t.join();
+  std::cout << finished << " tasks finished\n";
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include "../../coro/scheduler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+using clock_type = std::chrono::steady_clock;
+
+gkxx::Task<> counter(gkxx::Scheduler &scheduler, int calls, int &suspensions,
+                     const int &other_steps, int &interleaved) {
+  for (int i = 0; i != calls; ++i) {
+    auto before = other_steps;
+    co_await scheduler.maybe_yield();
+    if (other_steps != before) {
+      ++suspensions;
+      interleaved = std::max(interleaved, other_steps - before);
+    }
+  }
+}
+
+gkxx::Task<> stepper(gkxx::Scheduler &scheduler, int &steps, const bool &stop) {
+  while (!stop) {
+    ++steps;
+    co_await scheduler.suspend();
+  }
+}
+
+gkxx::Task<> set_after(gkxx::Task<> task, bool &flag) {
+  co_await std::move(task);
+  flag = true;
+}
+
+// With a budget of 100 calls, every 100th maybe_yield() lets the other
+// task take one step.
+void call_budget() {
+  gkxx::Scheduler scheduler{};
+  scheduler.set_yield_budget(100, std::chrono::seconds{10});
+  int suspensions = 0, steps = 0, interleaved = 0;
+  bool stop = false;
+  scheduler.spawn(set_after(
+      counter(scheduler, 10000, suspensions, steps, interleaved), stop));
+  scheduler.spawn(stepper(scheduler, steps, stop));
+  while (scheduler.schedule())
+    ;
+  assert(suspensions == 100 && interleaved == 1);
+  std::cout << "call budget: OK\n";
+}
+
+gkxx::Task<> hog(gkxx::Scheduler &scheduler, clock_type::duration length) {
+  auto until = clock_type::now() + length;
+  while (clock_type::now() < until)
+    co_await scheduler.maybe_yield();
+}
+
+gkxx::Task<> ticker(gkxx::Scheduler &scheduler, const bool &stop,
+                    clock_type::duration &longest) {
+  auto last = clock_type::now();
+  while (!stop) {
+    co_await scheduler.suspend();
+    auto now = clock_type::now();
+    longest = std::max(longest, now - last);
+    last = now;
+  }
+}
+
+// A task that spins for 50ms with a 1ms budget never keeps the other one
+// waiting for much longer than that.
+void time_budget() {
+  using namespace std::chrono_literals;
+  gkxx::Scheduler scheduler{};
+  scheduler.set_yield_budget(~std::uint64_t{0}, 1ms);
+  bool stop = false;
+  clock_type::duration longest{};
+  scheduler.spawn(set_after(hog(scheduler, 50ms), stop));
+  scheduler.spawn(ticker(scheduler, stop, longest));
+  while (scheduler.schedule())
+    ;
+  assert(longest < 10ms);
+  std::cout << "time budget: longest wait "
+            << std::chrono::duration<double, std::milli>(longest).count()
+            << " ms: OK\n";
+}
+
+int main() {
+  call_budget();
+  time_budget();
+  return 0;
+}
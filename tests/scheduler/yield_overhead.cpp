@@ -0,0 +1,119 @@
+// Cost of maybe_yield() in an inner loop, and what it buys. The first part
+// times a tight hashing loop with and without a yield point per iteration.
+// In the second, a hog running for a second shares the Scheduler with a
+// task that just reschedules itself; its waits are the hog's slices.
+//
+// usage: yield_overhead [iterations] [budget_us]
+#include "../../coro/scheduler.hpp"
+#include "../../tictoc.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+volatile std::uint64_t sink;
+
+std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 31;
+  x *= 0x7fb5d329728ea185ull;
+  return x ^ (x >> 27);
+}
+
+gkxx::Task<> plain(std::uint64_t iterations) {
+  std::uint64_t x = 1;
+  for (std::uint64_t i = 0; i != iterations; ++i)
+    x = mix(x + i);
+  sink = x;
+  co_return;
+}
+
+gkxx::Task<> yielding(gkxx::Scheduler &scheduler, std::uint64_t iterations) {
+  std::uint64_t x = 1;
+  for (std::uint64_t i = 0; i != iterations; ++i) {
+    x = mix(x + i);
+    co_await scheduler.maybe_yield();
+  }
+  sink = x;
+}
+
+double run_ns_per_iteration(gkxx::Task<> task, gkxx::Scheduler &scheduler,
+                            std::uint64_t iterations) {
+  auto clock = gkxx::tic();
+  scheduler.spawn(std::move(task));
+  while (scheduler.schedule())
+    ;
+  return std::chrono::duration<double, std::nano>(gkxx::toc(clock)).count() /
+         static_cast<double>(iterations);
+}
+
+gkxx::Task<> hog(gkxx::Scheduler &scheduler, bool yield, bool &stop) {
+  auto until = clock_type::now() + std::chrono::seconds{1};
+  std::uint64_t x = 1;
+  for (std::uint64_t i = 0; clock_type::now() < until; ++i) {
+    for (int k = 0; k != 100; ++k)
+      x = mix(x + i);
+    if (yield)
+      co_await scheduler.maybe_yield();
+    else if (i % 100000 == 0)
+      co_await scheduler.suspend();
+  }
+  sink = x;
+  stop = true;
+}
+
+gkxx::Task<> ticker(gkxx::Scheduler &scheduler, const bool &stop,
+                    std::vector<double> &waits) {
+  auto last = clock_type::now();
+  while (!stop) {
+    co_await scheduler.suspend();
+    auto now = clock_type::now();
+    waits.push_back(
+        std::chrono::duration<double, std::milli>(now - last).count());
+    last = now;
+  }
+}
+
+void report_waits(const char *name, bool yield,
+                  std::chrono::microseconds budget) {
+  gkxx::Scheduler scheduler{};
+  scheduler.set_yield_budget(~std::uint64_t{0}, budget);
+  bool stop = false;
+  std::vector<double> waits;
+  scheduler.spawn(hog(scheduler, yield, stop));
+  scheduler.spawn(ticker(scheduler, stop, waits));
+  while (scheduler.schedule())
+    ;
+  std::sort(waits.begin(), waits.end());
+  std::printf("  %-34s %6zu resumes   p99 %7.3f ms   max %7.3f ms\n", name,
+              waits.size(),
+              waits[static_cast<std::size_t>(
+                  0.99 * static_cast<double>(waits.size() - 1))],
+              waits.back());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::uint64_t iterations = argc > 1 ? std::stoull(argv[1]) : 100000000;
+  std::chrono::microseconds budget{argc > 2 ? std::stol(argv[2]) : 500};
+  gkxx::Scheduler scheduler{};
+  scheduler.set_yield_budget(~std::uint64_t{0}, budget);
+  auto without = run_ns_per_iteration(plain(iterations), scheduler,
+                                      iterations);
+  auto with = run_ns_per_iteration(yielding(scheduler, iterations), scheduler,
+                                   iterations);
+  std::printf("hash loop: %.2f ns/iteration plain, %.2f with maybe_yield() "
+              "(+%.2f ns)\n",
+              without, with, with - without);
+  std::printf("waits next to a 1s hog, %ld us budget:\n",
+              static_cast<long>(budget.count()));
+  report_waits("suspend() every 100000 iterations", false, budget);
+  report_waits("maybe_yield() every iteration", true, budget);
+  return 0;
+}
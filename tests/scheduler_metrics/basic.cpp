@@ -0,0 +1,76 @@
+#define GKXX_SCHEDULER_METRICS
+#include "../../coro/scheduler.hpp"
+#include "../../coro/scheduler_metrics.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+gkxx::Task<> hop(gkxx::Scheduler &scheduler, int times) {
+  for (int i = 0; i != times; ++i)
+    co_await scheduler.suspend();
+}
+
+gkxx::Task<> nap(gkxx::Scheduler &scheduler) {
+  co_await scheduler.sleep_for(std::chrono::milliseconds{20});
+}
+
+gkxx::Task<> hop(gkxx::WorkStealingScheduler &pool, int times) {
+  for (int i = 0; i != times; ++i)
+    co_await pool.suspend();
+}
+
+int main() {
+  static_assert(gkxx::SchedulerMetrics::enabled);
+  auto before = gkxx::SchedulerMetrics::snapshot();
+  {
+    gkxx::Scheduler scheduler{};
+    for (int i = 0; i != 10; ++i)
+      scheduler.spawn(hop(scheduler, 99));
+    while (scheduler.schedule())
+      ;
+    auto s = gkxx::SchedulerMetrics::snapshot() - before;
+    // Each task is resumed once to start and once per suspension.
+    assert(s.resumes == 1000);
+    // The other nine tasks are queued at every resume but the last few.
+    assert(s.queue_depth_max == 9);
+    assert(s.mean_queue_depth() > 8);
+    assert(s.busy.count() > 0 && s.mean_resume_ns() > 0);
+    assert(s.steals == 0 && s.steal_attempts == 0);
+
+    scheduler.spawn(nap(scheduler));
+    while (scheduler.schedule())
+      ;
+    s = gkxx::SchedulerMetrics::snapshot() - before;
+    assert(s.idle >= std::chrono::milliseconds{10});
+    std::cout << "Scheduler: " << s << '\n';
+  }
+
+  before = gkxx::SchedulerMetrics::snapshot();
+  {
+    gkxx::WorkStealingScheduler pool{4};
+    for (int i = 0; i != 100; ++i)
+      pool.spawn(hop(pool, 99));
+    pool.wait_idle();
+  }
+  // The workers have exited; their counts survive them.
+  auto s = gkxx::SchedulerMetrics::snapshot() - before;
+  assert(s.resumes == 10000);
+  assert(s.steals <= s.steal_attempts);
+  std::cout << "WorkStealingScheduler: " << s << '\n';
+
+  std::ostringstream dump;
+  {
+    gkxx::SchedulerMetricsDumper dumper{std::chrono::milliseconds{10}, dump};
+    gkxx::Scheduler scheduler{};
+    scheduler.spawn(hop(scheduler, 100));
+    while (scheduler.schedule())
+      ;
+    std::this_thread::sleep_for(std::chrono::milliseconds{35});
+  }
+  assert(dump.str().find("resumes 101,") != std::string::npos);
+  std::cout << "periodic dump: OK\n";
+  return 0;
+}
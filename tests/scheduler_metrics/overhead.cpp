@@ -0,0 +1,34 @@
+// Cost of the metrics layer per resume. Build it twice, with and without
+// -DGKXX_SCHEDULER_METRICS, and compare.
+//
+// usage: overhead [resumes]
+#include "../../coro/scheduler.hpp"
+#include "../../coro/scheduler_metrics.hpp"
+#include "../../tictoc.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+gkxx::Task<> hop(gkxx::Scheduler &scheduler, long times) {
+  for (long i = 0; i != times; ++i)
+    co_await scheduler.suspend();
+}
+
+int main(int argc, char **argv) {
+  long resumes = argc > 1 ? std::stol(argv[1]) : 10000000;
+  constexpr long tasks = 16;
+  gkxx::Scheduler scheduler{};
+  for (long i = 0; i != tasks; ++i)
+    scheduler.spawn(hop(scheduler, resumes / tasks));
+  auto start = gkxx::tic();
+  while (scheduler.schedule())
+    ;
+  auto elapsed = std::chrono::duration<double, std::nano>(gkxx::toc(start));
+  std::printf("metrics %s: %.2f ns per resume\n",
+              gkxx::SchedulerMetrics::enabled ? "on" : "off",
+              elapsed.count() / static_cast<double>(resumes));
+  if constexpr (gkxx::SchedulerMetrics::enabled)
+    std::cout << gkxx::SchedulerMetrics::snapshot() << '\n';
+  return 0;
+}
@@ -0,0 +1,163 @@
+#include "../../coro/channel.hpp"
+#include "../../coro/simulated_scheduler.hpp"
+#include "../../coro/sync.hpp"
+#include "../../tictoc.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Sim = gkxx::SimulatedScheduler;
+using namespace std::chrono_literals;
+
+gkxx::Task<> sleeper(Sim &sim, Sim::duration length, Sim::time_point &woke) {
+  co_await sim.sleep_for(length);
+  woke = sim.now();
+}
+
+void virtual_time() {
+  Sim sim{};
+  Sim::time_point a{}, b{};
+  auto wall = gkxx::tic();
+  sim.spawn(sleeper(sim, 3h, a));
+  sim.spawn(sleeper(sim, 90min, b));
+  while (sim.schedule())
+    ;
+  assert(a == Sim::time_point{3h} && b == Sim::time_point{90min});
+  assert(sim.now() == Sim::time_point{3h});
+  assert(gkxx::toc(wall) < 1s);
+  std::cout << "virtual time: OK\n";
+}
+
+// A client sends requests to a flaky server: each attempt fails with some
+// probability or times out, and the client retries with exponential
+// backoff. The trace is a function of the seed alone.
+struct Trace {
+  std::vector<std::string> events;
+  long attempts = 0;
+};
+
+gkxx::Task<> client(Sim &sim, int id, int requests, Trace &trace) {
+  for (int r = 0; r != requests; ++r) {
+    auto backoff = Sim::duration{100ms};
+    while (true) {
+      ++trace.attempts;
+      // Server latency: 10ms to 2s; anything over 1s is a timeout.
+      auto latency = 10ms + std::chrono::milliseconds{sim.random() % 1990};
+      auto lost = sim.random() % 4 == 0;
+      if (latency < 1s && !lost) {
+        co_await sim.sleep_for(latency);
+        break;
+      }
+      co_await sim.sleep_for(1s);
+      co_await sim.sleep_for(backoff);
+      backoff = std::min<Sim::duration>(backoff * 2, 1min);
+    }
+    if (r % 50 == 0)
+      trace.events.push_back(
+          std::to_string(id) + "@" +
+          std::to_string(sim.now().time_since_epoch().count()));
+  }
+}
+
+Trace simulate(std::uint64_t seed, int clients, int requests) {
+  Sim sim{seed};
+  Trace trace;
+  for (int i = 0; i != clients; ++i)
+    sim.spawn(client(sim, i, requests, trace));
+  while (sim.schedule())
+    ;
+  trace.events.push_back(
+      "end@" + std::to_string(sim.now().time_since_epoch().count()));
+  return trace;
+}
+
+void reproducible() {
+  auto wall = gkxx::tic();
+  auto first = simulate(42, 100, 1000);
+  auto ms = std::chrono::duration<double, std::milli>(gkxx::toc(wall));
+  auto second = simulate(42, 100, 1000);
+  auto other = simulate(43, 100, 1000);
+  assert(first.events == second.events && first.attempts == second.attempts);
+  assert(first.events != other.events);
+  auto simulated = std::stol(first.events.back().substr(4)) / 1e9 / 3600;
+  std::cout << "retries: " << first.attempts << " attempts over "
+            << simulated << " simulated hours in " << ms.count()
+            << " ms, reproducible: OK\n";
+}
+
+gkxx::Task<> append(Sim &sim, std::string &out, char c) {
+  for (int i = 0; i != 3; ++i) {
+    out += c;
+    co_await sim.suspend();
+  }
+}
+
+// Interleavings follow the seed.
+void interleavings() {
+  auto run = [](std::uint64_t seed) {
+    Sim sim{seed};
+    std::string out;
+    for (char c : std::string{"abcd"})
+      sim.spawn(append(sim, out, c));
+    while (sim.schedule())
+      ;
+    return out;
+  };
+  assert(run(1) == run(1));
+  bool differ = false;
+  for (std::uint64_t seed = 2; seed != 10; ++seed)
+    differ |= run(seed) != run(1);
+  assert(differ);
+  std::cout << "seeded interleavings: OK\n";
+}
+
+gkxx::Task<> produce(Sim &sim, gkxx::Channel<int, Sim> &out) {
+  for (int i = 1; i <= 100; ++i) {
+    co_await sim.sleep_for(1s);
+    co_await out.send(i);
+  }
+  out.close();
+}
+
+gkxx::Task<> consume(gkxx::Channel<int, Sim> &in, long &sum) {
+  while (auto x = co_await in.recv())
+    sum += *x;
+}
+
+gkxx::Task<> abandon(Sim &sim, bool &resumed) {
+  co_await sim.sleep_for(1h);
+  resumed = true;
+}
+
+// Channels and timers work as on Scheduler; a destroyed sleeper's timer is
+// cancelled.
+void compatibility() {
+  Sim sim{7};
+  gkxx::Channel<int, Sim> ch{sim, 4};
+  long sum = 0;
+  sim.spawn(consume(ch, sum));
+  sim.spawn(produce(sim, ch));
+  while (sim.schedule())
+    ;
+  assert(sum == 5050 && sim.now() == Sim::time_point{100s});
+
+  bool resumed = false;
+  auto sleeping = abandon(sim, resumed).release();
+  sim.post(sleeping);
+  sim.schedule();
+  sleeping.destroy();
+  sim.run_until(sim.now() + 2h);
+  assert(!resumed);
+  std::cout << "channel and cancelled timers: OK\n";
+}
+
+int main() {
+  virtual_time();
+  reproducible();
+  interleavings();
+  compatibility();
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include "../../coro/socket.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+int clients_done = 0;
+
+gkxx::Task<> echo(gkxx::Socket connection) {
+  std::byte buffer[256];
+  while (auto n = co_await connection.read(buffer)) {
+    std::size_t written = 0;
+    while (written != n)
+      written += co_await connection.write(
+          std::span<const std::byte>{buffer + written, n - written});
+  }
+}
+
+gkxx::Task<> serve(gkxx::Scheduler &scheduler, gkxx::Socket &listener,
+                   int connections) {
+  for (int i = 0; i != connections; ++i)
+    scheduler.spawn(echo(co_await listener.accept()));
+}
+
+// Writes a large message and reads it back concurrently, so that both
+// sides fill their socket buffers and have to wait for writability.
+gkxx::Task<> client(gkxx::Socket connection, int id) {
+  std::string message(1 << 20, static_cast<char>('a' + id));
+  std::string received(message.size(), '\0');
+  auto bytes = std::as_bytes(std::span{message});
+  std::size_t sent = 0, got = 0;
+  while (got != message.size()) {
+    if (sent != message.size())
+      sent += co_await connection.write(bytes.subspan(
+          sent, std::min<std::size_t>(65536, bytes.size() - sent)));
+    got += co_await connection.read(
+        std::as_writable_bytes(std::span{received}).subspan(got));
+  }
+  assert(received == message);
+  connection.close();
+  ++clients_done;
+}
+
+gkxx::Task<> run_clients(gkxx::Scheduler &scheduler, bool unix_socket,
+                         std::uint16_t port, const std::string &path,
+                         int count) {
+  for (int i = 0; i != count; ++i) {
+    gkxx::Socket connection;
+    if (unix_socket)
+      connection = co_await gkxx::Socket::connect_unix(scheduler, path);
+    else
+      connection = co_await gkxx::Socket::connect_tcp(scheduler, port);
+    scheduler.spawn(client(std::move(connection), i));
+  }
+}
+
+gkxx::Task<> refused(gkxx::Scheduler &scheduler, const std::string &path) {
+  try {
+    co_await gkxx::Socket::connect_unix(scheduler, path);
+    assert(false);
+  } catch (const std::system_error &e) {
+    std::cout << "connecting to a missing socket: " << e.what() << '\n';
+  }
+}
+
+int main() {
+  constexpr int count = 8;
+  gkxx::Scheduler scheduler{};
+  auto path = "/tmp/gkxx_socket_echo." + std::to_string(::getpid());
+
+  auto tcp = gkxx::Socket::listen_tcp(scheduler, 0);
+  scheduler.spawn(serve(scheduler, tcp, count));
+  scheduler.spawn(run_clients(scheduler, false, tcp.local_port(), "", count));
+  while (scheduler.schedule())
+    ;
+  assert(clients_done == count);
+  std::cout << count << " TCP clients echoed 1MiB each\n";
+
+  auto uds = gkxx::Socket::listen_unix(scheduler, path);
+  scheduler.spawn(serve(scheduler, uds, count));
+  scheduler.spawn(run_clients(scheduler, true, 0, path, count));
+  while (scheduler.schedule())
+    ;
+  assert(clients_done == 2 * count);
+  std::cout << count << " Unix socket clients echoed 1MiB each\n";
+  ::unlink(path.c_str());
+
+  scheduler.spawn(refused(scheduler, path));
+  while (scheduler.schedule())
+    ;
+  return 0;
+}
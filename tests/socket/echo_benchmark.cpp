@@ -0,0 +1,287 @@
+// Echo server benchmark: the coroutine Scheduler with epoll-driven sockets
+// against a thread-per-connection server, over loopback TCP and Unix
+// domain sockets. Every client is a thread doing blocking ping-pong, so
+// both servers see the same load.
+//
+// usage: echo_benchmark [connections] [requests per connection] [size]
+#include "../../coro/socket.hpp"
+#include "../../tictoc.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+struct Endpoint {
+  bool unix_socket = false;
+  std::uint16_t port = 0;
+  std::string path;
+};
+
+int blocking_connect(const Endpoint &endpoint) {
+  int fd;
+  if (endpoint.unix_socket) {
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s",
+                  endpoint.path.c_str());
+    if (::connect(fd, reinterpret_cast<::sockaddr *>(&addr), sizeof(addr)))
+      std::perror("connect");
+  } else {
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(endpoint.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<::sockaddr *>(&addr), sizeof(addr)))
+      std::perror("connect");
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  return fd;
+}
+
+bool read_exactly(int fd, char *data, std::size_t size) {
+  while (size != 0) {
+    auto n = ::read(fd, data, size);
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+bool write_all(int fd, const char *data, std::size_t size) {
+  while (size != 0) {
+    auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// Coroutine server: one Scheduler thread, one task per connection.
+
+gkxx::Task<> echo(gkxx::Socket connection) {
+  std::byte buffer[4096];
+  try {
+    while (auto n = co_await connection.read(buffer)) {
+      std::size_t written = 0;
+      while (written != n)
+        written += co_await connection.write(
+            std::span<const std::byte>{buffer + written, n - written});
+    }
+  } catch (const std::system_error &) {
+    // The client went away.
+  }
+}
+
+gkxx::Task<> accept_loop(gkxx::Scheduler &scheduler, gkxx::Socket &listener,
+                         const std::atomic<bool> &stop) {
+  while (true) {
+    auto connection = co_await listener.accept();
+    if (stop.load())
+      break;
+    scheduler.spawn(echo(std::move(connection)));
+  }
+}
+
+class CoroutineServer {
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_ready{false};
+  Endpoint m_endpoint;
+  std::thread m_thread;
+
+ public:
+  explicit CoroutineServer(bool unix_socket, const std::string &path) {
+    m_endpoint.unix_socket = unix_socket;
+    m_endpoint.path = path;
+    m_thread = std::thread{[this] {
+      gkxx::Scheduler scheduler{};
+      auto listener =
+          m_endpoint.unix_socket
+              ? gkxx::Socket::listen_unix(scheduler, m_endpoint.path)
+              : gkxx::Socket::listen_tcp(scheduler, 0);
+      if (!m_endpoint.unix_socket)
+        m_endpoint.port = listener.local_port();
+      m_ready.store(true);
+      m_ready.notify_all();
+      scheduler.spawn(accept_loop(scheduler, listener, m_stop));
+      while (scheduler.schedule())
+        ;
+    }};
+    m_ready.wait(false);
+  }
+  const Endpoint &endpoint() const {
+    return m_endpoint;
+  }
+  ~CoroutineServer() {
+    // Wake up the accept loop with one last connection.
+    m_stop.store(true);
+    ::close(blocking_connect(m_endpoint));
+    m_thread.join();
+  }
+};
+
+// Baseline: a blocking accept loop spawning one thread per connection.
+
+class ThreadServer {
+  std::atomic<bool> m_stop{false};
+  Endpoint m_endpoint;
+  int m_listener;
+  std::thread m_thread;
+  std::vector<std::thread> m_connections;
+
+ public:
+  explicit ThreadServer(bool unix_socket, const std::string &path) {
+    m_endpoint.unix_socket = unix_socket;
+    m_endpoint.path = path;
+    if (unix_socket) {
+      ::unlink(path.c_str());
+      m_listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      ::sockaddr_un addr{};
+      addr.sun_family = AF_UNIX;
+      std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+      ::bind(m_listener, reinterpret_cast<::sockaddr *>(&addr), sizeof(addr));
+    } else {
+      m_listener = ::socket(AF_INET, SOCK_STREAM, 0);
+      ::sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      ::bind(m_listener, reinterpret_cast<::sockaddr *>(&addr), sizeof(addr));
+      ::socklen_t len = sizeof(addr);
+      ::getsockname(m_listener, reinterpret_cast<::sockaddr *>(&addr), &len);
+      m_endpoint.port = ntohs(addr.sin_port);
+    }
+    ::listen(m_listener, SOMAXCONN);
+    m_thread = std::thread{[this] {
+      while (true) {
+        int fd = ::accept(m_listener, nullptr, nullptr);
+        if (m_stop.load()) {
+          ::close(fd);
+          break;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        m_connections.emplace_back([fd] {
+          char buffer[4096];
+          while (true) {
+            auto n = ::read(fd, buffer, sizeof(buffer));
+            if (n <= 0 || !write_all(fd, buffer, static_cast<std::size_t>(n)))
+              break;
+          }
+          ::close(fd);
+        });
+      }
+    }};
+  }
+  const Endpoint &endpoint() const {
+    return m_endpoint;
+  }
+  ~ThreadServer() {
+    m_stop.store(true);
+    ::close(blocking_connect(m_endpoint));
+    m_thread.join();
+    for (auto &t : m_connections)
+      t.join();
+    ::close(m_listener);
+  }
+};
+
+struct Result {
+  double requests_per_second;
+  std::chrono::nanoseconds p50, p99;
+};
+
+Result run_clients(const Endpoint &endpoint, int connections, int requests,
+                   std::size_t size) {
+  std::vector<std::vector<std::chrono::nanoseconds>> latencies(
+      static_cast<std::size_t>(connections));
+  std::vector<std::thread> clients;
+  std::atomic<int> connected{0};
+  std::atomic<bool> go{false};
+  for (int c = 0; c != connections; ++c)
+    clients.emplace_back([&, c] {
+      auto &mine = latencies[static_cast<std::size_t>(c)];
+      mine.reserve(static_cast<std::size_t>(requests));
+      std::string message(size, 'x'), reply(size, '\0');
+      int fd = blocking_connect(endpoint);
+      ++connected;
+      go.wait(false);
+      for (int i = 0; i != requests; ++i) {
+        auto start = gkxx::tic();
+        if (!write_all(fd, message.data(), size) ||
+            !read_exactly(fd, reply.data(), size))
+          break;
+        mine.push_back(gkxx::toc(start));
+      }
+      ::close(fd);
+    });
+  while (connected.load() != connections)
+    std::this_thread::yield();
+  auto start = gkxx::tic();
+  go.store(true);
+  go.notify_all();
+  for (auto &t : clients)
+    t.join();
+  auto elapsed = std::chrono::duration<double>(gkxx::toc(start)).count();
+
+  std::vector<std::chrono::nanoseconds> all;
+  for (auto &v : latencies)
+    all.insert(all.end(), v.begin(), v.end());
+  std::sort(all.begin(), all.end());
+  if (all.empty())
+    return {0, {}, {}};
+  return {static_cast<double>(all.size()) / elapsed, all[all.size() / 2],
+          all[all.size() * 99 / 100]};
+}
+
+void report(const char *name, const Result &result) {
+  std::printf("  %-24s %10.0f req/s   p50 %7.1fus   p99 %7.1fus\n", name,
+              result.requests_per_second,
+              static_cast<double>(result.p50.count()) / 1000,
+              static_cast<double>(result.p99.count()) / 1000);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int connections = argc > 1 ? std::stoi(argv[1]) : 16;
+  int requests = argc > 2 ? std::stoi(argv[2]) : 2000;
+  std::size_t size = argc > 3 ? std::stoul(argv[3]) : 64;
+  auto path = "/tmp/gkxx_echo_benchmark." + std::to_string(::getpid());
+  std::printf("%d connections x %d requests of %zu bytes\n", connections,
+              requests, size);
+
+  for (bool unix_socket : {false, true}) {
+    std::printf("%s:\n", unix_socket ? "Unix domain socket" : "TCP loopback");
+    {
+      CoroutineServer server{unix_socket, path};
+      report("coroutine + epoll",
+             run_clients(server.endpoint(), connections, requests, size));
+    }
+    {
+      ThreadServer server{unix_socket, path};
+      report("thread per connection",
+             run_clients(server.endpoint(), connections, requests, size));
+    }
+  }
+  ::unlink(path.c_str());
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include "../../coro/scheduler.hpp"
+#include "../../coro/sync.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// The critical section suspends, so the other tasks get to run while the
+// mutex is held; those that want it queue up in arrival order.
+gkxx::Task<> locker(gkxx::Scheduler &scheduler,
+                    gkxx::AsyncMutex<> &mutex, int id, bool &inside,
+                    std::vector<int> &order) {
+  co_await mutex.lock();
+  assert(!inside);
+  inside = true;
+  order.push_back(id);
+  co_await scheduler.suspend();
+  inside = false;
+  mutex.unlock();
+}
+
+gkxx::Task<> bystander(gkxx::Scheduler &scheduler, const bool &inside,
+                       int &progress_while_locked) {
+  for (int i = 0; i != 20; ++i) {
+    progress_while_locked += inside;
+    co_await scheduler.suspend();
+  }
+}
+
+void mutex_on_scheduler() {
+  gkxx::Scheduler scheduler{};
+  gkxx::AsyncMutex mutex{scheduler};
+  bool inside = false;
+  int progress = 0;
+  std::vector<int> order;
+  for (int i = 0; i != 10; ++i)
+    scheduler.spawn(locker(scheduler, mutex, i, inside, order));
+  scheduler.spawn(bystander(scheduler, inside, progress));
+  while (scheduler.schedule())
+    ;
+  assert((order == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  assert(progress > 0);
+  assert(mutex.try_lock());
+  mutex.unlock();
+  std::cout << "AsyncMutex on Scheduler: OK\n";
+}
+
+using Pool = gkxx::WorkStealingScheduler;
+
+gkxx::Task<> add(Pool &pool, gkxx::AsyncMutex<Pool> &mutex, long &counter,
+                 int times) {
+  for (int i = 0; i != times; ++i) {
+    auto guard = co_await mutex.scoped_lock();
+    auto value = counter;
+    if (i % 16 == 0)
+      co_await pool.suspend();
+    counter = value + 1;
+  }
+}
+
+void mutex_on_pool() {
+  long counter = 0;
+  {
+    Pool pool{4};
+    gkxx::AsyncMutex mutex{pool};
+    for (int i = 0; i != 64; ++i)
+      pool.spawn(add(pool, mutex, counter, 1000));
+    pool.wait_idle();
+  }
+  assert(counter == 64000);
+  std::cout << "AsyncMutex on 4 workers: OK\n";
+}
+
+gkxx::Task<> limited(Pool &pool, gkxx::AsyncSemaphore<Pool> &semaphore,
+                     std::atomic<int> &running, std::atomic<int> &peak) {
+  for (int i = 0; i != 100; ++i) {
+    co_await semaphore.acquire();
+    auto now = ++running;
+    auto seen = peak.load();
+    while (now > seen && !peak.compare_exchange_weak(seen, now))
+      ;
+    co_await pool.suspend();
+    --running;
+    semaphore.release();
+  }
+}
+
+void semaphore_on_pool() {
+  std::atomic<int> running{0}, peak{0};
+  {
+    Pool pool{4};
+    gkxx::AsyncSemaphore semaphore{pool, 3};
+    for (int i = 0; i != 32; ++i)
+      pool.spawn(limited(pool, semaphore, running, peak));
+    pool.wait_idle();
+    // All three permits are back.
+    assert(semaphore.try_acquire() && semaphore.try_acquire() &&
+           semaphore.try_acquire() && !semaphore.try_acquire());
+  }
+  assert(peak.load() <= 3 && running.load() == 0);
+  std::cout << "AsyncSemaphore on 4 workers: OK\n";
+}
+
+// Scheduler runs tasks in FIFO order, so all three permits get used.
+gkxx::Task<> limited(gkxx::Scheduler &scheduler,
+                     gkxx::AsyncSemaphore<> &semaphore, int &running,
+                     int &peak) {
+  for (int i = 0; i != 10; ++i) {
+    co_await semaphore.acquire();
+    peak = std::max(peak, ++running);
+    co_await scheduler.suspend();
+    --running;
+    semaphore.release();
+  }
+}
+
+void semaphore_on_scheduler() {
+  gkxx::Scheduler scheduler{};
+  gkxx::AsyncSemaphore semaphore{scheduler, 3};
+  int running = 0, peak = 0;
+  for (int i = 0; i != 8; ++i)
+    scheduler.spawn(limited(scheduler, semaphore, running, peak));
+  while (scheduler.schedule())
+    ;
+  assert(peak == 3 && running == 0);
+  semaphore.release(2);
+  for (int i = 0; i != 5; ++i)
+    assert(semaphore.try_acquire());
+  assert(!semaphore.try_acquire());
+  std::cout << "AsyncSemaphore on Scheduler: OK\n";
+}
+
+gkxx::Task<> wait_for(gkxx::AsyncManualResetEvent<> &event, int &woken) {
+  co_await event;
+  ++woken;
+}
+
+void event_on_scheduler() {
+  gkxx::Scheduler scheduler{};
+  gkxx::AsyncManualResetEvent event{scheduler};
+  int woken = 0;
+  for (int i = 0; i != 5; ++i)
+    scheduler.spawn(wait_for(event, woken));
+  while (scheduler.schedule())
+    ;
+  assert(woken == 0 && !event.is_set());
+
+  // Set from another thread; the scheduler picks the waiters up through
+  // submit().
+  std::thread setter{[&] { event.set(); }};
+  setter.join();
+  while (scheduler.schedule())
+    ;
+  assert(woken == 5);
+
+  // Already set: no suspension.
+  scheduler.spawn(wait_for(event, woken));
+  scheduler.schedule();
+  assert(woken == 6);
+
+  event.reset();
+  scheduler.spawn(wait_for(event, woken));
+  while (scheduler.schedule())
+    ;
+  assert(woken == 6);
+  event.set();
+  while (scheduler.schedule())
+    ;
+  assert(woken == 7);
+  std::cout << "AsyncManualResetEvent: OK\n";
+}
+
+int main() {
+  mutex_on_scheduler();
+  mutex_on_pool();
+  semaphore_on_scheduler();
+  semaphore_on_pool();
+  event_on_scheduler();
+  return 0;
+}
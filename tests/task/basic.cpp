@@ -0,0 +1,48 @@
+#include "../../coro/scheduler.hpp"
+#include "../../coro/task.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Each level awaits the next one. With optimizations enabled, symmetric
+// transfer compiles to tail calls and the stack does not grow with the depth
+// of the chain.
+gkxx::Task<long> sum_to(long n) {
+  if (n == 0)
+    co_return 0;
+  co_return n + co_await sum_to(n - 1);
+}
+
+gkxx::Task<std::string> greet(gkxx::Scheduler &scheduler, std::string name) {
+  co_await scheduler.suspend();
+  co_return "hello, " + name;
+}
+
+gkxx::Task<int> failing() {
+  throw std::runtime_error{"task failed"};
+  co_return 0;
+}
+
+gkxx::Task<> run(gkxx::Scheduler &scheduler) {
+  std::cout << co_await greet(scheduler, "task") << '\n';
+  auto t = greet(scheduler, "lvalue");
+  std::cout << co_await t << " (" << t.is_ready() << ")\n";
+  try {
+    co_await failing();
+  } catch (const std::runtime_error &e) {
+    std::cout << "caught: " << e.what() << '\n';
+  }
+}
+
+int main() {
+  gkxx::Scheduler scheduler{};
+  auto sum = gkxx::sync_wait(scheduler, sum_to(10000));
+  std::cout << "sum_to(10000) = " << sum << '\n';
+  gkxx::sync_wait(scheduler, run(scheduler));
+
+  gkxx::WorkStealingScheduler pool{2};
+  auto pooled = gkxx::sync_wait(pool, sum_to(1000));
+  std::cout << "on the pool: " << pooled << '\n';
+  return sum == 50005000 && pooled == 500500 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+// A three-level validation chain written four ways: throwing, C++
+// exceptions, std::expected and error codes. Each is timed on inputs that
+// all pass and on inputs that all fail at the innermost level, with the
+// number of operator new calls per call (exception objects come from malloc
+// and are not counted). Build it twice, once as is and once with
+// -DGKXX_THROWING_NO_FRAME_STACK, to compare the frame stack against the
+// global operator new; std::expected needs -std=c++23. The last line times
+// try_catch with 16 handlers, the matching one last.
+//
+// usage: benchmark [calls]
+#include "../../throwing.hpp"
+#include "../../tictoc.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
+namespace {
+
+std::size_t allocations = 0;
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+struct out_of_range_error {
+  int value;
+};
+
+constexpr int limit = 1000;
+
+gkxx::throwing<int> check_range(int x) {
+  if (x >= limit)
+    co_yield out_of_range_error{x};
+  co_return x;
+}
+gkxx::throwing<int> validate(int x) {
+  auto checked = co_await check_range(x);
+  co_return checked * 2;
+}
+gkxx::throwing<int> parse_field(int x) {
+  auto valid = co_await validate(x);
+  co_return valid + 1;
+}
+
+[[gnu::noinline]] int check_range_exc(int x) {
+  if (x >= limit)
+    throw out_of_range_error{x};
+  return x;
+}
+[[gnu::noinline]] int validate_exc(int x) {
+  return check_range_exc(x) * 2;
+}
+[[gnu::noinline]] int parse_field_exc(int x) {
+  return validate_exc(x) + 1;
+}
+
+#ifdef __cpp_lib_expected
+[[gnu::noinline]] std::expected<int, out_of_range_error>
+check_range_exp(int x) {
+  if (x >= limit)
+    return std::unexpected{out_of_range_error{x}};
+  return x;
+}
+[[gnu::noinline]] std::expected<int, out_of_range_error> validate_exp(int x) {
+  auto checked = check_range_exp(x);
+  if (!checked)
+    return std::unexpected{checked.error()};
+  return *checked * 2;
+}
+[[gnu::noinline]] std::expected<int, out_of_range_error>
+parse_field_exp(int x) {
+  auto valid = validate_exp(x);
+  if (!valid)
+    return std::unexpected{valid.error()};
+  return *valid + 1;
+}
+#endif
+
+[[gnu::noinline]] bool check_range_code(int x, int &out, int &error) {
+  if (x >= limit) {
+    error = x;
+    return false;
+  }
+  out = x;
+  return true;
+}
+[[gnu::noinline]] bool validate_code(int x, int &out, int &error) {
+  int checked;
+  if (!check_range_code(x, checked, error))
+    return false;
+  out = checked * 2;
+  return true;
+}
+[[gnu::noinline]] bool parse_field_code(int x, int &out, int &error) {
+  int valid;
+  if (!validate_code(x, valid, error))
+    return false;
+  out = valid + 1;
+  return true;
+}
+
+// Each call returns the parsed value, or -1 after handling the error.
+int call_throwing(int x) {
+  return gkxx::try_catch([x] { return parse_field(x); },
+                         [](const out_of_range_error &) { return -1; });
+}
+template <int Code>
+struct other_error {
+  int value;
+};
+
+template <std::size_t... Codes>
+int call_throwing_with(int x, std::index_sequence<Codes...>) {
+  return gkxx::try_catch(
+      [x] { return parse_field(x); },
+      [](const other_error<static_cast<int>(Codes)> &) {
+        return static_cast<int>(Codes);
+      }...,
+      [](const out_of_range_error &) { return -1; });
+}
+int call_throwing_many(int x) {
+  return call_throwing_with(x, std::make_index_sequence<15>{});
+}
+
+int call_exceptions(int x) {
+  try {
+    return parse_field_exc(x);
+  } catch (const out_of_range_error &) {
+    return -1;
+  }
+}
+#ifdef __cpp_lib_expected
+int call_expected(int x) {
+  auto result = parse_field_exp(x);
+  return result ? *result : -1;
+}
+#endif
+int call_error_code(int x) {
+  int out, error;
+  return parse_field_code(x, out, error) ? out : -1;
+}
+
+volatile int sink;
+
+template <typename Call>
+void run(const char *name, Call call, long calls) {
+  std::printf("%-12s", name);
+  for (int first : {0, limit}) {
+    auto before = allocations;
+    auto clock = gkxx::tic();
+    for (long i = 0; i != calls; ++i)
+      sink = call(first + static_cast<int>(i % limit));
+    auto ns = std::chrono::duration<double, std::nano>(gkxx::toc(clock));
+    std::printf("  %9.1f ns %6.2f allocs",
+                ns.count() / static_cast<double>(calls),
+                static_cast<double>(allocations - before) /
+                    static_cast<double>(calls));
+  }
+  std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  long calls = argc > 1 ? std::stol(argv[1]) : 1000000;
+#ifdef GKXX_THROWING_NO_FRAME_STACK
+  std::printf("throwing frames from operator new\n");
+#else
+  std::printf("throwing frames from the frame stack\n");
+#endif
+  std::printf("%-12s  %26s  %26s\n", "per call", "success", "failure");
+  run("throwing", call_throwing, calls);
+  run("exceptions", call_exceptions, calls);
+#ifdef __cpp_lib_expected
+  run("expected", call_expected, calls);
+#endif
+  run("error code", call_error_code, calls);
+  run("throwing/16", call_throwing_many, calls);
+  return 0;
+}
@@ -0,0 +1,255 @@
+#include "../../throwing.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+
+std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+struct validation_error {
+  virtual ~validation_error() = default;
+  virtual int code() const noexcept = 0;
+};
+struct tagged {
+  char tag[8] = "tagged";
+};
+// The second base sits at a nonzero offset.
+struct field_error : validation_error, tagged {
+  int field;
+  explicit field_error(int f) : field{f} {}
+  int code() const noexcept override {
+    return 100 + field;
+  }
+};
+struct empty_field_error : field_error {
+  using field_error::field_error;
+  int code() const noexcept override {
+    return 200 + field;
+  }
+};
+
+template <>
+struct gkxx::error_bases<field_error> {
+  using type = gkxx::error_base_list<validation_error, tagged>;
+};
+template <>
+struct gkxx::error_bases<empty_field_error> {
+  using type = gkxx::error_base_list<field_error>;
+};
+
+struct counted {
+  static inline int alive = 0;
+  counted() noexcept {
+    ++alive;
+  }
+  counted(counted &&) noexcept {
+    ++alive;
+  }
+  ~counted() {
+    --alive;
+  }
+};
+
+gkxx::throwing<int> check(int field) {
+  if (field == 0)
+    co_yield empty_field_error{7};
+  if (field < 0)
+    co_yield field_error{-field};
+  co_return field;
+}
+
+gkxx::throwing<int> check_twice(int field) {
+  auto first = co_await check(field);
+  auto second = co_await check(first - 1);
+  co_return first + second;
+}
+
+void hierarchy() {
+  auto by_abstract_base = gkxx::try_catch(
+      [] { return check_twice(1); },
+      [](const validation_error &e) { return e.code(); });
+  assert(by_abstract_base == 207);
+
+  auto by_second_base = gkxx::try_catch(
+      [] { return check(-3); },
+      [](const tagged &t) { return std::string{t.tag} == "tagged" ? 1 : 0; });
+  assert(by_second_base == 1);
+
+  // The first matching handler wins, as with catch clauses.
+  auto derived_first = gkxx::try_catch(
+      [] { return check(0); }, [](empty_field_error &) { return 1; },
+      [](field_error &) { return 2; });
+  auto base_first = gkxx::try_catch(
+      [] { return check(0); }, [](field_error &) { return 2; },
+      [](empty_field_error &) { return 1; });
+  assert(derived_first == 1 && base_first == 2);
+
+  auto value = gkxx::try_catch([] { return check_twice(5); },
+                               [](const validation_error &) { return -1; });
+  assert(value == 9);
+  std::cout << "hierarchy: OK\n";
+}
+
+gkxx::throwing<int> raise_counted() {
+  co_yield counted{};
+  co_return 0;
+}
+
+void lifetimes() {
+  auto handled =
+      gkxx::try_catch([] { return raise_counted(); }, [] { return 1; });
+  assert(handled == 1 && counted::alive == 0);
+
+  bool thrown = false;
+  try {
+    (void)gkxx::try_catch([] { return check(-1); },
+                          [](const std::exception &) { return 1; });
+  } catch (const field_error &e) {
+    thrown = e.field == 1;
+  }
+  assert(thrown);
+
+  // A handler may raise and catch errors of its own.
+  auto nested = gkxx::try_catch(
+      [] { return check(-2); },
+      [](const field_error &outer) {
+        auto inner = gkxx::try_catch([] { return check(-9); },
+                                     [](const field_error &e) {
+                                       return e.field;
+                                     });
+        return outer.field * 10 + inner;
+      });
+  assert(nested == 29);
+  std::cout << "lifetimes: OK\n";
+}
+
+void no_allocations() {
+  (void)gkxx::try_catch([] { return check_twice(1); }, [] { return 0; });
+  auto before = allocations;
+  int sum = 0;
+  for (int i = 0; i != 1000; ++i)
+    sum += gkxx::try_catch([i] { return check(-(i % 10)); },
+                           [](const empty_field_error &) { return 0; },
+                           [](const field_error &e) { return e.field; });
+  assert(sum == 4500 && allocations == before);
+  std::cout << "no allocations: OK\n";
+}
+
+gkxx::throwing<int> handled(int field) {
+  co_return gkxx::try_catch([field] { return check(field); },
+                            [](const field_error &e) { return e.field; });
+}
+
+// Each failed call keeps its own error until it is awaited.
+gkxx::throwing<int> await_later(int first, int second, bool nested) {
+  auto a = check(first);
+  auto b = nested ? handled(second) : check(second);
+  auto x = co_await std::move(a);
+  auto y = co_await std::move(b);
+  co_return x + y;
+}
+
+void deferred() {
+  auto after_handled = gkxx::try_catch(
+      [] { return await_later(-3, -4, true); },
+      [](const field_error &e) { return e.field; });
+  assert(after_handled == 3);
+
+  auto first_of_two = gkxx::try_catch(
+      [] { return await_later(-3, 0, false); },
+      [](const empty_field_error &) { return 0; },
+      [](const field_error &e) { return e.field; });
+  assert(first_of_two == 3);
+
+  auto second_of_two = gkxx::try_catch(
+      [] { return await_later(2, 0, false); },
+      [](const empty_field_error &e) { return e.field * 10; },
+      [](const field_error &e) { return e.field; });
+  assert(second_of_two == 70);
+  std::cout << "deferred: OK\n";
+}
+
+template <int N>
+struct numbered_error {
+  int n = N;
+};
+
+template <int N>
+gkxx::throwing<int> raise_numbered() {
+  co_yield numbered_error<N>{};
+  co_return -1;
+}
+
+template <std::size_t... Ns>
+gkxx::throwing<int> raise_numbered(int n, std::index_sequence<Ns...>) {
+  using raiser = gkxx::throwing<int> (*)();
+  static constexpr raiser raisers[] = {&raise_numbered<Ns>...};
+  auto value = co_await raisers[n]();
+  co_return value;
+}
+
+// One try_catch site, and so one dispatch table, for every error type.
+int classify(int n) {
+  return gkxx::try_catch(
+      [n] { return raise_numbered(n, std::make_index_sequence<300>{}); },
+      [](const numbered_error<0> &) { return 0; },
+      [](const numbered_error<1> &e) { return e.n; },
+      [](const numbered_error<2> &e) { return e.n; },
+      [](const numbered_error<3> &e) { return e.n; },
+      [](const numbered_error<4> &e) { return e.n; },
+      [](const numbered_error<5> &e) { return e.n; },
+      [](const numbered_error<6> &e) { return e.n; },
+      [](const numbered_error<7> &e) { return e.n; },
+      [](const numbered_error<299> &e) { return e.n; }, [] { return -2; });
+}
+
+template <int N>
+gkxx::throwing<int> field_or_numbered(int field) {
+  if (field == 0)
+    co_yield numbered_error<N>{};
+  auto value = co_await check(field);
+  co_return value;
+}
+
+void dispatch_table() {
+  // More error types than the table has entries.
+  for (int round = 0; round != 2; ++round)
+    for (int n = 0; n != 300; ++n)
+      assert(classify(n) == (n < 8 || n == 299 ? n : -2));
+
+  // Same site, errors found through different bases.
+  auto site = [](int field) {
+    return gkxx::try_catch([field] { return field_or_numbered<1>(field); },
+                           [](const empty_field_error &) { return 1; },
+                           [](const tagged &) { return 2; },
+                           [](const validation_error &) { return 3; },
+                           [](const numbered_error<1> &) { return 4; });
+  };
+  for (int round = 0; round != 2; ++round)
+    assert(site(-1) == 2 && site(0) == 4 && site(5) == 5);
+  std::cout << "dispatch table: OK\n";
+}
+
+int main() {
+  hierarchy();
+  lifetimes();
+  deferred();
+  no_allocations();
+  dispatch_table();
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include "../../throwing.hpp"
+#include <array>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+gkxx::throwing<int> checked_sum(int n) {
+  if (n < 0)
+    co_yield std::invalid_argument{"negative"};
+  if (n == 0)
+    co_return 0;
+  auto rest = co_await checked_sum(n - 1);
+  co_return n + rest;
+}
+
+gkxx::throwing<int> fails_at(int n, int depth) {
+  if (depth == 0)
+    co_yield std::range_error{"bottom"};
+  auto rest = co_await fails_at(n, depth - 1);
+  co_return rest + 1;
+}
+
+gkxx::throwing<int> throws_inside() {
+  throw std::out_of_range{"thrown"};
+  co_return 0;
+}
+
+// Big enough to need a chunk of its own.
+gkxx::throwing<int> big_frame(int x) {
+  std::array<volatile char, 100000> buffer{};
+  buffer[x] = static_cast<char>(x);
+  co_return buffer[x];
+}
+
+void values_and_errors() {
+  auto sum = gkxx::try_catch([] { return checked_sum(1000); },
+                             [](const std::exception &) { return -1; });
+  assert(sum == 500500);
+
+  auto caught = gkxx::try_catch(
+      [] { return fails_at(0, 1000); },
+      [](const std::invalid_argument &) { return 1; },
+      [](const std::runtime_error &) { return 2; }, [] { return 3; });
+  assert(caught == 2);
+
+  auto caught_all = gkxx::try_catch([] { return checked_sum(-1); },
+                                    [](const std::range_error &) { return 1; },
+                                    [] { return 3; });
+  assert(caught_all == 3);
+
+  auto from_throw = gkxx::try_catch(
+      [] { return throws_inside(); },
+      [](const std::out_of_range &e) { return e.what()[0] == 't' ? 4 : 0; });
+  assert(from_throw == 4);
+
+  bool rethrown = false;
+  try {
+    (void)gkxx::try_catch([] { return fails_at(0, 10); },
+                          [](const std::invalid_argument &) { return 1; });
+  } catch (const std::range_error &) {
+    rethrown = true;
+  }
+  assert(rethrown);
+  std::cout << "values and errors: OK\n";
+}
+
+void no_allocations() {
+  // Warm up the chunks first.
+  (void)gkxx::try_catch([] { return checked_sum(1000); }, [] { return 0; });
+  auto before = allocations;
+  for (int i = 0; i != 1000; ++i) {
+    auto sum = gkxx::try_catch([i] { return checked_sum(i % 100); },
+                               [] { return -1; });
+    assert(sum == (i % 100) * (i % 100 + 1) / 2);
+  }
+  assert(allocations == before);
+  std::cout << "no allocations: OK\n";
+}
+
+void out_of_order() {
+  void *first;
+  {
+    auto a = checked_sum(0);
+    auto b = checked_sum(0);
+    first = a.handle.address();
+    {
+      auto dropped = std::move(a);
+    }
+    // `a` is only marked free while `b` sits above it.
+    auto c = checked_sum(0);
+    assert(c.handle.address() != first);
+  }
+  auto d = checked_sum(0);
+  assert(d.handle.address() == first);
+  std::cout << "out of order: OK\n";
+}
+
+void large_frames() {
+  for (int i = 0; i != 3; ++i) {
+    auto x = gkxx::try_catch([] { return checked_sum(5); }, [] { return -1; });
+    auto y = gkxx::try_catch([i] { return big_frame(i); }, [] { return -1; });
+    assert(x == 15 && y == i);
+  }
+  std::cout << "large frames: OK\n";
+}
+
+void threads() {
+  auto work = [] {
+    for (int i = 0; i != 100; ++i) {
+      auto sum =
+          gkxx::try_catch([] { return checked_sum(2000); }, [] { return -1; });
+      assert(sum == 2001000);
+    }
+  };
+  std::thread t1{work}, t2{work};
+  t1.join();
+  t2.join();
+  std::cout << "threads: OK\n";
+}
+
+int main() {
+  values_and_errors();
+  no_allocations();
+  out_of_order();
+  large_frames();
+  threads();
+  return 0;
+}
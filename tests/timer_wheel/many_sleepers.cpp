@@ -0,0 +1,35 @@
+#include "../../coro/scheduler.hpp"
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+int woken = 0;
+
+gkxx::Task<> sleeper(gkxx::Scheduler &scheduler, int i) {
+  // A few rounds of timeouts spread over 200ms.
+  for (int round = 0; round != 3; ++round)
+    co_await scheduler.sleep_for(std::chrono::milliseconds{50 + i % 150});
+  ++woken;
+}
+
+static double cpu_seconds() {
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? std::stoi(argv[1]) : 20000;
+  gkxx::Scheduler scheduler{};
+  for (int i = 0; i != n; ++i)
+    scheduler.spawn(sleeper(scheduler, i));
+  auto cpu = cpu_seconds();
+  auto wall = gkxx::tic();
+  while (scheduler.schedule())
+    ;
+  auto elapsed = std::chrono::duration<double>(gkxx::toc(wall)).count();
+  cpu = cpu_seconds() - cpu;
+  std::cout << woken << " of " << n << " sleepers woke up 3 times\n"
+            << "wall " << elapsed << "s, cpu " << cpu << "s ("
+            << 100 * cpu / elapsed << "% of one core)\n";
+  return woken == n ? 0 : 1;
+}
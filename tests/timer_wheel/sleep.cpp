@@ -0,0 +1,40 @@
+#include "../../coro/scheduler.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+std::vector<int> order;
+
+gkxx::Task<> sleeper(gkxx::Scheduler &scheduler, int ms) {
+  co_await scheduler.sleep_for(std::chrono::milliseconds{ms});
+  order.push_back(ms);
+}
+
+gkxx::Task<> forgotten(gkxx::Scheduler &scheduler) {
+  co_await scheduler.sleep_for(std::chrono::hours{1});
+}
+
+int main() {
+  gkxx::Scheduler scheduler{};
+  for (int ms : {30, 10, 50, 0, 20, 40})
+    scheduler.spawn(sleeper(scheduler, ms));
+  auto start = gkxx::tic();
+  while (scheduler.schedule())
+    ;
+  auto elapsed = gkxx::toc(start);
+  assert((order == std::vector{0, 10, 20, 30, 40, 50}));
+  assert(elapsed >= std::chrono::milliseconds{50});
+  std::cout << "woke up in order after " << elapsed << '\n';
+
+  // Destroying a sleeping task cancels its timer.
+  {
+    auto task = forgotten(scheduler);
+    auto handle = std::move(task).release();
+    handle.resume();
+    assert(scheduler.m_timers.size() == 1);
+    handle.destroy();
+    assert(scheduler.m_timers.empty());
+  }
+  return 0;
+}
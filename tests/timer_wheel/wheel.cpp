@@ -0,0 +1,51 @@
+#include "../../coro/timer_wheel.hpp"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+int main() {
+  using namespace std::chrono_literals;
+  gkxx::TimerWheel wheel{};
+  auto origin = gkxx::TimerWheel::clock_type::now();
+  // Spread over all four levels and beyond the range of the wheel.
+  const std::vector<gkxx::TimerWheel::duration> delays{
+      5ms, 1ms, 63ms, 64ms, 4095ms, 4096ms, 70min, 6h, 3ms};
+  std::vector<gkxx::TimerNode> nodes(delays.size());
+  for (std::size_t i = 0; i != delays.size(); ++i)
+    wheel.insert(nodes[i], origin + delays[i]);
+  wheel.cancel(nodes.back());
+  assert(wheel.size() == delays.size() - 1);
+
+  std::vector<gkxx::TimerNode *> fired;
+  auto expect = [&](gkxx::TimerWheel::duration at, std::size_t count) {
+    wheel.advance(origin + at,
+                  [&](gkxx::TimerNode &node) { fired.push_back(&node); });
+    assert(fired.size() == count);
+    for (auto node : fired)
+      assert(delays[static_cast<std::size_t>(node - nodes.data())] <= at);
+  };
+  expect(0ms, 0);
+  expect(2ms, 1);
+  expect(62ms, 2);
+  expect(65ms, 4);
+  expect(4095ms, 4);
+  expect(4097ms, 6);
+  auto deadline = wheel.next_deadline();
+  assert(deadline && *deadline <= origin + 70min);
+  expect(70min + 1ms, 7);
+  expect(6h + 1ms, 8);
+  assert(wheel.empty() && !wheel.next_deadline());
+
+  // A timer filed on level 1 comes due before a later one on level 0.
+  gkxx::TimerWheel mixed{};
+  auto start = gkxx::TimerWheel::clock_type::now();
+  gkxx::TimerNode outer, inner;
+  mixed.insert(outer, start + 80ms);
+  mixed.advance(start + 60ms, [](gkxx::TimerNode &) { assert(false); });
+  mixed.insert(inner, start + 110ms);
+  auto next = mixed.next_deadline();
+  assert(next && *next <= start + 80ms);
+  std::cout << fired.size() << " timers fired on time\n";
+  return 0;
+}
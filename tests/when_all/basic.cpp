@@ -0,0 +1,95 @@
+#include "../../coro/scheduler.hpp"
+#include "../../coro/when_all.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::atomic<std::size_t> allocations{0};
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (auto p = std::malloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+template <typename Executor>
+gkxx::Task<int> square(Executor &executor, int x) {
+  co_await executor.suspend();
+  co_return x * x;
+}
+
+template <typename Executor>
+gkxx::Task<std::string> name(Executor &executor) {
+  co_await executor.suspend();
+  co_return "when_all";
+}
+
+gkxx::Task<> nothing() {
+  co_return;
+}
+
+template <typename Executor>
+gkxx::Task<int> failing(Executor &executor) {
+  co_await executor.suspend();
+  throw std::runtime_error("failed");
+}
+
+template <typename Executor>
+gkxx::Task<int> fan_out(Executor &executor, int n) {
+  std::vector<gkxx::Task<int>> tasks;
+  for (int i = 1; i <= n; ++i)
+    tasks.push_back(square(executor, i));
+  auto squares = co_await gkxx::when_all(std::move(tasks));
+  int sum = 0;
+  for (auto x : squares)
+    sum += x;
+  co_return sum;
+}
+
+gkxx::Task<> variadic(gkxx::Scheduler &scheduler) {
+  auto a = square(scheduler, 3);
+  auto b = name(scheduler);
+  auto c = nothing();
+  // The tasks' frames are already allocated; awaiting them is not.
+  auto before = allocations.load();
+  auto [x, s, v] =
+      co_await gkxx::when_all(std::move(a), std::move(b), std::move(c));
+  assert(allocations.load() == before);
+  assert(x == 9 && s == "when_all");
+  (void)v;
+
+  try {
+    co_await gkxx::when_all(square(scheduler, 2), failing(scheduler));
+    assert(false);
+  } catch (const std::runtime_error &e) {
+    assert(std::string{e.what()} == "failed");
+  }
+  std::cout << "variadic when_all: OK\n";
+}
+
+int main() {
+  gkxx::Scheduler scheduler{};
+  // Warm up the scheduler's queue so that it does not allocate later.
+  gkxx::sync_wait(scheduler, square(scheduler, 0));
+  gkxx::sync_wait(scheduler, variadic(scheduler));
+  assert(gkxx::sync_wait(scheduler, fan_out(scheduler, 100)) == 338350);
+
+  gkxx::WorkStealingScheduler pool{4};
+  for (int round = 0; round != 100; ++round)
+    assert(gkxx::sync_wait(pool, fan_out(pool, 100)) == 338350);
+  std::cout << "range when_all on 4 workers: OK\n";
+  return 0;
+}
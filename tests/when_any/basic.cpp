@@ -0,0 +1,83 @@
+#include "../../coro/scheduler.hpp"
+#include "../../coro/when_any.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::atomic<int> finished{0};
+
+gkxx::Task<int> after(gkxx::Scheduler &scheduler, int ms) {
+  co_await scheduler.sleep_for(std::chrono::milliseconds{ms});
+  ++finished;
+  co_return ms;
+}
+
+gkxx::Task<std::string> immediately() {
+  ++finished;
+  co_return "first";
+}
+
+gkxx::Task<> failing(gkxx::Scheduler &scheduler) {
+  co_await scheduler.suspend();
+  ++finished;
+  throw std::runtime_error("failed");
+}
+
+gkxx::Task<> race(gkxx::Scheduler &scheduler) {
+  auto r = co_await gkxx::when_any(after(scheduler, 30), after(scheduler, 10),
+                                   after(scheduler, 20));
+  assert(r.index() == 1 && std::get<1>(r) == 10);
+
+  // Finishes while being started: the remaining task is never started.
+  auto s = co_await gkxx::when_any(immediately(), after(scheduler, 5));
+  assert(s.index() == 0 && std::get<0>(s) == "first");
+
+  try {
+    co_await gkxx::when_any(failing(scheduler), after(scheduler, 50));
+    assert(false);
+  } catch (const std::runtime_error &) {
+  }
+
+  std::vector<gkxx::Task<int>> tasks;
+  for (int ms : {40, 15, 25})
+    tasks.push_back(after(scheduler, ms));
+  auto [index, value] = co_await gkxx::when_any(std::move(tasks));
+  assert(index == 1 && value == 15);
+  std::cout << "when_any on Scheduler: OK\n";
+}
+
+gkxx::Task<int> spin(gkxx::WorkStealingScheduler &pool, int rounds) {
+  for (int i = 0; i != rounds; ++i)
+    co_await pool.suspend();
+  co_return rounds;
+}
+
+gkxx::Task<int> race_on_pool(gkxx::WorkStealingScheduler &pool) {
+  std::vector<gkxx::Task<int>> tasks;
+  for (int i = 0; i != 8; ++i)
+    tasks.push_back(spin(pool, 10 + i));
+  auto [index, value] = co_await gkxx::when_any(std::move(tasks));
+  co_return value - static_cast<int>(index);
+}
+
+int main() {
+  gkxx::Scheduler scheduler{};
+  gkxx::sync_wait(scheduler, race(scheduler));
+  // The losers were detached and still run to completion; the one task
+  // that was never started does not.
+  while (scheduler.schedule())
+    ;
+  assert(finished == 9);
+
+  gkxx::WorkStealingScheduler pool{4};
+  for (int round = 0; round != 200; ++round)
+    assert(gkxx::sync_wait(pool, race_on_pool(pool)) == 10);
+  pool.wait_idle();
+  std::cout << "when_any on 4 workers: OK\n";
+  return 0;
+}
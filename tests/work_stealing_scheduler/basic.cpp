@@ -0,0 +1,33 @@
+#include "../../coro/task.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+std::atomic<int> steps{0};
+std::mutex threads_mutex;
+std::set<std::thread::id> threads;
+
+gkxx::Task<> worker(gkxx::WorkStealingScheduler &scheduler, int rounds) {
+  for (int i = 0; i != rounds; ++i) {
+    steps.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard lock{threads_mutex};
+      threads.insert(std::this_thread::get_id());
+    }
+    co_await scheduler.suspend();
+  }
+}
+
+int main() {
+  constexpr int tasks = 1000, rounds = 50;
+  gkxx::WorkStealingScheduler scheduler{4};
+  for (int i = 0; i != tasks; ++i)
+    scheduler.spawn(worker(scheduler, rounds));
+  scheduler.wait_idle();
+  std::cout << steps << " steps on " << threads.size() << " of "
+            << scheduler.worker_count() << " workers\n";
+  return steps == tasks * rounds ? 0 : 1;
+}
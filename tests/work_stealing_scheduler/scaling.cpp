@@ -0,0 +1,62 @@
+#include "../../coro/task.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include "../../tictoc.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+// Usage: scaling [max_threads] [tasks]
+// CPU-bound tasks that count primes in slices and yield between slices.
+
+std::atomic<unsigned> primes{0};
+
+bool is_prime(unsigned n) {
+  if (n < 2)
+    return false;
+  for (unsigned d = 2; d * d <= n; ++d)
+    if (n % d == 0)
+      return false;
+  return true;
+}
+
+gkxx::Task<> count_primes(gkxx::WorkStealingScheduler &scheduler,
+                          unsigned first, unsigned last) {
+  unsigned count = 0;
+  for (auto n = first; n < last; ++n) {
+    count += is_prime(n);
+    if ((n - first) % 1000 == 999)
+      co_await scheduler.suspend();
+  }
+  primes.fetch_add(count, std::memory_order_relaxed);
+}
+
+int main(int argc, char **argv) {
+  unsigned max_threads = argc > 1 ? std::atoi(argv[1])
+                                  : std::thread::hardware_concurrency();
+  unsigned tasks = argc > 2 ? std::atoi(argv[2]) : 256;
+  constexpr unsigned per_task = 20000;
+  if (max_threads == 0)
+    max_threads = 1;
+
+  double base = 0;
+  for (unsigned threads = 1; threads <= max_threads; ++threads) {
+    primes = 0;
+    auto clock = gkxx::tic();
+    {
+      gkxx::WorkStealingScheduler scheduler{threads};
+      for (unsigned i = 0; i != tasks; ++i)
+        scheduler.spawn(
+            count_primes(scheduler, i * per_task, (i + 1) * per_task));
+      scheduler.wait_idle();
+    }
+    auto ms = std::chrono::duration<double, std::milli>(gkxx::toc(clock))
+                  .count();
+    if (threads == 1)
+      base = ms;
+    std::cout << threads << " threads: " << ms << " ms, speedup "
+              << base / ms << ", primes " << primes << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,30 @@
+#include "../../coro/task.hpp"
+#include "../../coro/work_stealing_scheduler.hpp"
+#include <atomic>
+#include <iostream>
+
+gkxx::Task<> set_flag(std::atomic<bool> &flag) {
+  flag.store(true, std::memory_order_relaxed);
+  co_return;
+}
+
+// Spawns the task that sets the flag onto its own worker's deque, then
+// waits for it by suspending.
+gkxx::Task<> wait_for_flag(gkxx::WorkStealingScheduler &scheduler,
+                           std::atomic<bool> &flag, int &turns) {
+  scheduler.spawn(set_flag(flag));
+  while (!flag.load(std::memory_order_relaxed)) {
+    ++turns;
+    co_await scheduler.suspend();
+  }
+}
+
+int main() {
+  gkxx::WorkStealingScheduler scheduler{1};
+  std::atomic<bool> flag{false};
+  int turns = 0;
+  scheduler.spawn(wait_for_flag(scheduler, flag, turns));
+  scheduler.wait_idle();
+  std::cout << "flag set after " << turns << " suspend()s\n";
+  return flag && turns == 1 ? 0 : 1;
+}
@@ -1,33 +1,461 @@
 #ifndef GKXX_THROWING_HPP
 #define GKXX_THROWING_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace gkxx {
 
+namespace detail {
+
+  // Per-thread LIFO arena for throwing frames. A throwing call runs to
+  // completion or to its first error before returning, and its frame lives
+  // in a temporary of the caller, so frames die in the reverse order of
+  // their creation: allocation is a pointer bump and freeing the newest
+  // frame moves the pointer back. A frame freed out of order is only marked
+  // and reclaimed together with the ones above it. Chunks are kept for
+  // reuse until the thread exits.
+  //
+  // Frames have to be destroyed on the thread that created them.
+  class frame_stack {
+    static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    static constexpr std::size_t chunk_size = 64 * 1024;
+
+    struct alignas(alignment) chunk {
+      chunk *prev;
+      chunk *next;
+      std::byte *end;
+
+      std::byte *data() noexcept {
+        return reinterpret_cast<std::byte *>(this + 1);
+      }
+    };
+
+    // The low bit of `below` marks a frame freed out of order.
+    struct alignas(alignment) header {
+      std::uintptr_t below;
+      chunk *owner;
+    };
+    static constexpr std::uintptr_t freed = 1;
+
+    static inline thread_local chunk *tl_chunk = nullptr;
+    static inline thread_local std::byte *tl_next = nullptr;
+    static inline thread_local std::byte *tl_end = nullptr;
+    static inline thread_local header *tl_top = nullptr;
+    static inline thread_local bool tl_exited = false;
+
+    struct thread_holder {
+      ~thread_holder() {
+        tl_exited = true;
+        auto c = tl_chunk;
+        while (c && c->prev)
+          c = c->prev;
+        while (c) {
+          auto next = c->next;
+          ::operator delete(c);
+          c = next;
+        }
+        tl_chunk = nullptr;
+        tl_next = tl_end = nullptr;
+        tl_top = nullptr;
+      }
+    };
+
+    // Moves on to the chunk after the current one, replacing it if it is
+    // too small for `need` bytes.
+    [[gnu::noinline]] static void grow(std::size_t need) {
+      auto prev = tl_chunk;
+      auto next = prev ? prev->next : nullptr;
+      if (!next || static_cast<std::size_t>(next->end - next->data()) < need) {
+        auto rest = next;
+        if (next) {
+          rest = next->next;
+          ::operator delete(next);
+        }
+        auto bytes = sizeof(chunk) + std::max(chunk_size, need);
+        next = static_cast<chunk *>(::operator new(bytes));
+        next->prev = prev;
+        next->next = rest;
+        next->end = reinterpret_cast<std::byte *>(next) + bytes;
+        if (prev)
+          prev->next = next;
+        if (rest)
+          rest->prev = next;
+        if (!tl_exited) {
+          thread_local thread_holder holder;
+        }
+      }
+      tl_chunk = next;
+      tl_next = next->data();
+      tl_end = next->end;
+    }
+
+   public:
+    static void *allocate(std::size_t size) {
+      auto need =
+          sizeof(header) + (size + alignment - 1) / alignment * alignment;
+      if (static_cast<std::size_t>(tl_end - tl_next) < need)
+        grow(need);
+      auto block = ::new (tl_next)
+          header{reinterpret_cast<std::uintptr_t>(tl_top), tl_chunk};
+      tl_top = block;
+      tl_next += need;
+      return block + 1;
+    }
+
+    static void deallocate(void *frame) noexcept {
+      auto block = static_cast<header *>(frame) - 1;
+      if (block != tl_top) {
+        block->below |= freed;
+        return;
+      }
+      while (true) {
+        tl_chunk = block->owner;
+        tl_next = reinterpret_cast<std::byte *>(block);
+        tl_end = block->owner->end;
+        tl_top = reinterpret_cast<header *>(block->below & ~freed);
+        if (!tl_top || !(tl_top->below & freed))
+          break;
+        block = tl_top;
+      }
+    }
+  };
+
+  struct error_info;
+
+  struct error_base {
+    const error_info *info;
+    void *(*upcast)(void *) noexcept;
+  };
+
+  // What try_catch() needs to know about an error type, built at compile
+  // time. Its address serves as the type's id.
+  struct error_info {
+    const error_base *bases;
+    std::size_t base_count;
+    void (*relocate)(void *from, void *to) noexcept;
+    void (*destroy)(void *) noexcept;
+    void (*raise)(void *);
+    // Dense number of the type, handed out on first use.
+    std::uint32_t (*index)() noexcept;
+  };
+
+  inline std::atomic<std::uint32_t> next_error_index{0};
+
+} // namespace detail
+
+template <typename... Bases>
+struct error_base_list {};
+
+// The direct bases of an error type, through which a handler taking a base
+// catches it; there is no RTTI to find them. Specialize it for error types
+// derived from other error types. The standard exceptions are declared
+// below.
+template <typename Error>
+struct error_bases {
+  using type = error_base_list<>;
+};
+
+#define GKXX_THROWING_ERROR_BASE(Error, Base)                                 \
+  template <>                                                                 \
+  struct error_bases<Error> {                                                 \
+    using type = error_base_list<Base>;                                       \
+  };
+GKXX_THROWING_ERROR_BASE(std::logic_error, std::exception)
+GKXX_THROWING_ERROR_BASE(std::domain_error, std::logic_error)
+GKXX_THROWING_ERROR_BASE(std::invalid_argument, std::logic_error)
+GKXX_THROWING_ERROR_BASE(std::length_error, std::logic_error)
+GKXX_THROWING_ERROR_BASE(std::out_of_range, std::logic_error)
+GKXX_THROWING_ERROR_BASE(std::runtime_error, std::exception)
+GKXX_THROWING_ERROR_BASE(std::range_error, std::runtime_error)
+GKXX_THROWING_ERROR_BASE(std::overflow_error, std::runtime_error)
+GKXX_THROWING_ERROR_BASE(std::underflow_error, std::runtime_error)
+#undef GKXX_THROWING_ERROR_BASE
+
+namespace detail {
+
+  template <typename Derived, typename Base>
+  void *upcast_error(void *error) noexcept {
+    return static_cast<Base *>(static_cast<Derived *>(error));
+  }
+
+  template <typename Error>
+  struct error_type {
+    static void relocate(void *from, void *to) noexcept {
+      auto &error = *static_cast<Error *>(from);
+      ::new (to) Error(std::move(error));
+      error.~Error();
+    }
+    static void destroy(void *error) noexcept {
+      static_cast<Error *>(error)->~Error();
+    }
+    static std::uint32_t index() noexcept {
+      static const std::uint32_t ret =
+          next_error_index.fetch_add(1, std::memory_order_relaxed);
+      return ret;
+    }
+    static void raise(void *error) {
+      // An exception caught inside a throwing call goes back to being one.
+      if constexpr (std::is_same_v<Error, std::exception_ptr>)
+        std::rethrow_exception(*static_cast<Error *>(error));
+      else
+        throw std::move(*static_cast<Error *>(error));
+    }
+
+    template <typename... Bases>
+    static constexpr auto make_bases(error_base_list<Bases...>) noexcept {
+      return std::array<error_base, sizeof...(Bases)>{
+          error_base{&error_type<Bases>::info, &upcast_error<Error, Bases>}...};
+    }
+
+    // Types only ever caught as a base, like abstract ones, need no
+    // operations.
+    static constexpr error_info make_info() noexcept {
+      if constexpr (std::is_nothrow_move_constructible_v<Error>)
+        return {bases.data(), bases.size(), &relocate, &destroy, &raise,
+                &index};
+      else
+        return {bases.data(), bases.size(), nullptr, nullptr, nullptr,
+                &index};
+    }
+
+    static constexpr auto bases =
+        make_bases(typename error_bases<Error>::type{});
+    static constexpr error_info info = make_info();
+  };
+
+  inline bool derives_from(const error_info *info,
+                           const error_info *target) noexcept {
+    if (info == target)
+      return true;
+    for (std::size_t i = 0; i != info->base_count; ++i)
+      if (derives_from(info->bases[i].info, target))
+        return true;
+    return false;
+  }
+
+  // Finds `target` among the error's type and its bases, and returns the
+  // error as that type.
+  inline void *find_error(const error_info *info, void *error,
+                          const error_info *target) noexcept {
+    if (info == target)
+      return error;
+    for (std::size_t i = 0; i != info->base_count; ++i) {
+      auto &base = info->bases[i];
+      if (auto found = find_error(base.info, base.upcast(error), target))
+        return found;
+    }
+    return nullptr;
+  }
+
+  // Inline storage for one error of any type that fits, without the heap
+  // or RTTI.
+  class error_slot {
+   public:
+    static constexpr std::size_t capacity = 64;
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+   private:
+    alignas(alignment) std::byte m_storage[capacity];
+    const error_info *m_info = nullptr;
+
+   public:
+    error_slot() noexcept = default;
+    error_slot(const error_slot &) = delete;
+    ~error_slot() {
+      clear();
+    }
+
+    bool empty() const noexcept {
+      return !m_info;
+    }
+    const error_info *info() const noexcept {
+      return m_info;
+    }
+
+    template <typename Error>
+    void store(Error &&error) {
+      using type = std::remove_cvref_t<Error>;
+      static_assert(sizeof(type) <= capacity && alignof(type) <= alignment,
+                    "error types must fit in an error_slot");
+      static_assert(std::is_nothrow_move_constructible_v<type>,
+                    "error types must be nothrow move constructible");
+      clear();
+      ::new (static_cast<void *>(m_storage)) type(std::forward<Error>(error));
+      m_info = &error_type<type>::info;
+    }
+
+    void clear() noexcept {
+      if (m_info) {
+        m_info->destroy(m_storage);
+        m_info = nullptr;
+      }
+    }
+
+    void move_to(error_slot &other) noexcept {
+      other.clear();
+      if (m_info) {
+        m_info->relocate(m_storage, other.m_storage);
+        other.m_info = std::exchange(m_info, nullptr);
+      }
+    }
+
+    // The error as an `Error`, if it is one or derives from one.
+    template <typename Error>
+    Error *find() noexcept {
+      return m_info ? static_cast<Error *>(find_error(
+                          m_info, m_storage, &error_type<Error>::info))
+                    : nullptr;
+    }
+
+    [[noreturn]] void raise() {
+      m_info->raise(m_storage);
+      __builtin_unreachable();
+    }
+  };
+
+  // The error try_catch() took out of the top-level call, so that
+  // handlers may raise and catch errors of their own.
+  class caught_error {
+    error_slot m_slot;
+
+   public:
+    explicit caught_error(error_slot &from) noexcept {
+      from.move_to(m_slot);
+    }
+    caught_error(const caught_error &) = delete;
+
+    error_slot &slot() noexcept {
+      return m_slot;
+    }
+  };
+
+  // The part of a throwing call's state that does not depend on its value
+  // type. A throwing call runs from its start to its first suspension
+  // without interruption and never resumes after it, so the calls running
+  // on a thread form a stack, and the caller awaiting a call is always the
+  // innermost one still running.
+  class running_call {
+    static inline thread_local running_call *tl_running = nullptr;
+
+    running_call *m_below;
+
+   public:
+    error_slot error;
+
+    running_call() noexcept : m_below{tl_running} {
+      tl_running = this;
+    }
+    running_call(const running_call &) = delete;
+
+    static running_call *top() noexcept {
+      return tl_running;
+    }
+
+    // Called once, when the call suspends for good.
+    void leave() noexcept {
+      tl_running = m_below;
+    }
+
+    // Takes over the error of a call this one awaited, and stops.
+    void fail_with(running_call &callee) noexcept {
+      callee.error.move_to(error);
+      leave();
+    }
+  };
+
+} // namespace detail
+
+// How a throwing call ended: with a value, or with an error. The error
+// stays in the failed call's frame until an awaiting caller takes it over,
+// so a call may be awaited well after it failed.
 template <typename Type>
-struct exit_condition;
+struct exit_condition : detail::running_call {
+  union {
+    Type value;
+  };
+  bool has_value = false;
+
+  exit_condition() noexcept {}
+  exit_condition(const exit_condition &) = delete;
+  ~exit_condition() {
+    if (has_value)
+      std::destroy_at(std::addressof(value));
+  }
+
+  bool is_value() const noexcept {
+    return has_value;
+  }
+
+  template <typename U>
+  void store_value(U &&v) {
+    std::construct_at(std::addressof(value), std::forward<U>(v));
+    has_value = true;
+  }
+  template <typename U>
+  void store_exception(U &&e) {
+    error.store(std::forward<U>(e));
+  }
+  void store_current_exception() noexcept {
+    error.store(std::current_exception());
+  }
+};
 
+// Return type of a coroutine that reports errors with `co_yield error;`.
+// Awaiting another throwing call yields its value, or stops the awaiting
+// coroutine and passes the error on. An exception thrown inside is caught
+// and passed on the same way. Use try_catch() at the top to handle errors.
 template <typename Type>
 struct [[nodiscard]] throwing {
   struct promise_type {
+    using value_type = Type;
+
+#ifndef GKXX_THROWING_NO_FRAME_STACK
+    // Frames come from the calling thread's detail::frame_stack.
+    static void *operator new(std::size_t size) {
+      return detail::frame_stack::allocate(size);
+    }
+    static void operator delete(void *frame) noexcept {
+      detail::frame_stack::deallocate(frame);
+    }
+#endif
+
     throwing get_return_object() {
       return throwing{std::coroutine_handle<promise_type>::from_promise(*this)};
     }
-    std::suspend_never initial_suspend();
-    std::suspend_always final_suspend() noexcept;
+    std::suspend_never initial_suspend() const noexcept {
+      return {};
+    }
+    std::suspend_always final_suspend() noexcept {
+      condition.leave();
+      return {};
+    }
 
     template <typename U>
     std::suspend_always yield_value(U &&value) {
       condition.store_exception(std::forward<U>(value));
+      condition.leave();
       return {};
     }
     template <typename U>
     void return_value(U &&value) {
       condition.store_value(std::forward<U>(value));
     }
-    void unhandled_exception() {}
+    void unhandled_exception() noexcept {
+      condition.store_current_exception();
+    }
 
     exit_condition<Type> condition;
   };
@@ -45,17 +473,192 @@ struct [[nodiscard]] throwing {
     return handle.promise().condition.is_value();
   }
   Type await_resume() {
-    return std::move(handle.promise().condition).value;
+    return std::move(handle.promise().condition.value);
   }
+  // The caller stays suspended and takes the error over, to pass it on
+  // in turn. Only throwing calls may await one. The caller is found through
+  // detail::running_call rather than the handle, which GCC 12 gets wrong
+  // for a co_await in an if condition.
   template <typename OuterPromise>
-  void await_suspend(std::coroutine_handle<OuterPromise> outer_handle) {
-    outer_handle.promise().condition.propogate_error(
-        handle.promise().condition);
+    requires std::is_same_v<
+        OuterPromise,
+        typename throwing<typename OuterPromise::value_type>::promise_type>
+  void await_suspend(std::coroutine_handle<OuterPromise>) const noexcept {
+    auto caller = detail::running_call::top();
+    assert(caller && "awaiting a throwing call outside of one");
+    caller->fail_with(handle.promise().condition);
   }
 
   std::coroutine_handle<promise_type> handle{};
 };
 
+namespace detail {
+
+  template <typename Signature>
+  struct handler_traits;
+
+  template <typename R, bool NE>
+  struct handler_traits<R (*)() noexcept(NE)> {
+    static constexpr bool catch_all = true;
+  };
+  template <typename R, typename Arg, bool NE>
+  struct handler_traits<R (*)(Arg) noexcept(NE)> {
+    static constexpr bool catch_all = false;
+    using error_type = std::remove_reference_t<Arg>;
+  };
+  template <typename R, typename Class, typename... Args, bool NE>
+  struct handler_traits<R (Class::*)(Args...) noexcept(NE)>
+      : handler_traits<R (*)(Args...)> {};
+  template <typename R, typename Class, typename... Args, bool NE>
+  struct handler_traits<R (Class::*)(Args...) const noexcept(NE)>
+      : handler_traits<R (*)(Args...)> {};
+
+  // Handlers are lambdas or other function objects with one non-template
+  // operator(), or plain functions.
+  template <typename Handler>
+  struct handler_traits_of : handler_traits<std::decay_t<Handler>> {};
+  template <typename Handler>
+    requires requires { &Handler::operator(); }
+  struct handler_traits_of<Handler>
+      : handler_traits<decltype(&Handler::operator())> {};
+
+  // Tries the handlers in order, like the catch clauses of a try block. An
+  // error no handler takes is thrown as an exception. Used directly only for
+  // exceptions caught inside throwing calls, which have to be rethrown to
+  // be matched.
+  template <typename Result>
+  Result dispatch_error(error_slot &error) {
+    error.raise();
+  }
+  template <typename Result, typename Handler, typename... Rest>
+  Result dispatch_error(error_slot &error, Handler &handler, Rest &...rest) {
+    using traits = handler_traits_of<std::remove_cv_t<Handler>>;
+    if constexpr (traits::catch_all) {
+      return handler();
+    } else {
+      using error_type = typename traits::error_type;
+      if (auto found = error.find<std::remove_cv_t<error_type>>())
+        return handler(*found);
+      if constexpr (!std::is_same_v<std::remove_cv_t<error_type>,
+                                    std::exception_ptr>) {
+        if (auto exception = error.find<std::exception_ptr>()) {
+          try {
+            std::rethrow_exception(*exception);
+          } catch (error_type &e) {
+            return handler(e);
+          } catch (...) {
+          }
+        }
+      }
+      return dispatch_error<Result>(error, rest...);
+    }
+  }
+
+  // Picks the handler for an error in constant time, whatever the number
+  // of handlers. The handler list is turned into a jump table at compile
+  // time; which entry an error type takes is worked out on its first
+  // dispatch, in handler order, and kept in a table indexed by the type's
+  // dense index.
+  template <typename Result, typename... Handlers>
+  class handler_table {
+    static constexpr std::size_t count = sizeof...(Handlers);
+    static_assert(count < 0xffff);
+    static constexpr std::size_t table_size = 256;
+    using handlers_type = std::tuple<Handlers &...>;
+    using entry_type = Result (*)(error_slot &, handlers_type &);
+
+    template <typename Handler>
+    using traits = handler_traits_of<std::remove_cv_t<Handler>>;
+
+    // The error type each handler takes; null for a catch-all.
+    template <typename Handler>
+    static constexpr const error_info *target() noexcept {
+      if constexpr (traits<Handler>::catch_all)
+        return nullptr;
+      else
+        return &error_type<
+            std::remove_cv_t<typename traits<Handler>::error_type>>::info;
+    }
+    static constexpr std::array<const error_info *, count> targets{
+        target<Handlers>()...};
+
+    template <std::size_t I>
+    static Result call(error_slot &error, handlers_type &handlers) {
+      auto &handler = std::get<I>(handlers);
+      using handler_type = std::tuple_element_t<I, std::tuple<Handlers...>>;
+      if constexpr (traits<handler_type>::catch_all) {
+        return handler();
+      } else {
+        using type =
+            std::remove_cv_t<typename traits<handler_type>::error_type>;
+        return handler(*error.find<type>());
+      }
+    }
+    static Result unhandled(error_slot &error, handlers_type &) {
+      error.raise();
+    }
+
+    template <std::size_t... Is>
+    static constexpr std::array<entry_type, count + 1>
+    make_entries(std::index_sequence<Is...>) noexcept {
+      return {&call<Is>..., &unhandled};
+    }
+    static constexpr auto entries =
+        make_entries(std::index_sequence_for<Handlers...>{});
+
+    static std::size_t resolve(const error_info *info) noexcept {
+      std::size_t i = 0;
+      for (; i != count; ++i)
+        if (!targets[i] || derives_from(info, targets[i]))
+          break;
+      return i;
+    }
+
+   public:
+    // `error` must hold an error.
+    static Result dispatch(error_slot &error, Handlers &...handlers) {
+      auto info = error.info();
+      assert(info && "dispatching an empty error_slot");
+      if (info == &error_type<std::exception_ptr>::info)
+        return dispatch_error<Result>(error, handlers...);
+      // Entry plus one, zero until the error type is first seen. Threads
+      // racing on an entry store the same value. Types past the table are
+      // looked up every time.
+      static std::atomic<std::uint16_t> table[table_size];
+      auto index = info->index();
+      std::size_t entry;
+      if (index < table_size) {
+        entry = table[index].load(std::memory_order_relaxed);
+        if (entry == 0) {
+          entry = resolve(info) + 1;
+          table[index].store(static_cast<std::uint16_t>(entry),
+                             std::memory_order_relaxed);
+        }
+      } else {
+        entry = resolve(info) + 1;
+      }
+      handlers_type refs{handlers...};
+      return entries[entry - 1](error, refs);
+    }
+  };
+
+} // namespace detail
+
+// Calls `body`, which returns a throwing<T>, and returns its value. On an
+// error the first handler taking it (by its parameter type, or a handler
+// with no parameter) is called instead and its result returned.
+template <typename Body, typename... Handlers>
+auto try_catch(Body &&body, Handlers &&...handlers) {
+  auto result = std::forward<Body>(body)();
+  using result_type = decltype(result.await_resume());
+  if (result.await_ready())
+    return result.await_resume();
+  detail::caught_error error{result.handle.promise().condition.error};
+  return detail::handler_table<result_type,
+                               std::remove_reference_t<Handlers>...>::
+      dispatch(error.slot(), handlers...);
+}
+
 } // namespace gkxx
 
-#endif // GKXX_THROWING_HPP
\ No newline at end of file
+#endif // GKXX_THROWING_HPP